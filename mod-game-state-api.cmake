@@ -13,3 +13,24 @@ target_include_directories(modules
     ${CMAKE_CURRENT_LIST_DIR}/include)
 
 message("  -> Game State API Module: Added utilities, nlohmann/json, and httplib include paths")
+
+# Response compression: gzip through the zlib AzerothCore already depends on,
+# zstd only when the library is installed
+target_link_libraries(modules
+  PUBLIC
+    zlib)
+
+find_path(GAMESTATE_API_ZSTD_INCLUDE_DIR zstd.h)
+find_library(GAMESTATE_API_ZSTD_LIBRARY zstd)
+if (GAMESTATE_API_ZSTD_INCLUDE_DIR AND GAMESTATE_API_ZSTD_LIBRARY)
+  target_include_directories(modules
+    PRIVATE
+      ${GAMESTATE_API_ZSTD_INCLUDE_DIR})
+  target_link_libraries(modules
+    PUBLIC
+      ${GAMESTATE_API_ZSTD_LIBRARY})
+  target_compile_definitions(modules
+    PRIVATE
+      GAMESTATE_API_ZSTD)
+  message("  -> Game State API Module: zstd response compression enabled")
+endif()
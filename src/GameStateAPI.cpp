@@ -3,11 +3,50 @@
  */
 
 #include "GameStateAPI.h"
+#include "GameStateSnapshot.h"
+#include "GameStateUtilities.h"
 #include "HttpGameStateServer.h"
 #include "Log.h"
 #include "Config.h"
+#include <charconv>
+#include <string_view>
 
-GameStateAPI::GameStateAPI() : WorldScript("GameStateAPI"), _enabled(false), _port(8080)
+// Parse a CPU list such as "0-3,8,10-11"; false if it is malformed
+// CPU_SETSIZE of glibc, no thread can be pinned to a higher CPU number
+static constexpr uint32 MAX_LISTENER_CPUS = 1024;
+
+static bool ParseCpuList(std::string_view text, std::vector<uint32>& cpus)
+{
+    while (!text.empty())
+    {
+        std::size_t comma = text.find(',');
+        std::string_view item = text.substr(0, comma);
+        text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+
+        uint32 first = 0;
+        std::from_chars_result result = std::from_chars(item.data(), item.data() + item.size(), first);
+        if (result.ec != std::errc() || first >= MAX_LISTENER_CPUS)
+            return false;
+
+        uint32 last = first;
+        if (result.ptr != item.data() + item.size())
+        {
+            if (*result.ptr != '-')
+                return false;
+
+            result = std::from_chars(result.ptr + 1, item.data() + item.size(), last);
+            if (result.ec != std::errc() || result.ptr != item.data() + item.size() || last < first || last >= MAX_LISTENER_CPUS)
+                return false;
+        }
+
+        for (uint32 cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+
+    return true;
+}
+
+GameStateAPI::GameStateAPI() : WorldScript("GameStateAPI"), _enabled(false), _port(8080), _snapshotInterval(100)
 {
 }
 
@@ -25,6 +64,33 @@ void GameStateAPI::OnAfterConfigLoad(bool /*reload*/)
     _host = sConfigMgr->GetOption<std::string>("GameStateAPI.Host", "127.0.0.1");
     _port = static_cast<uint16>(sConfigMgr->GetOption<int32>("GameStateAPI.Port", 8080));
     _allowedOrigin = sConfigMgr->GetOption<std::string>("GameStateAPI.AllowedOrigin", "*");
+    _snapshotInterval = sConfigMgr->GetOption<uint32>("GameStateAPI.SnapshotInterval", 100);
+    _limits.Threads = sConfigMgr->GetOption<uint32>("GameStateAPI.Threads", 0);
+    _limits.MaxQueuedRequests = sConfigMgr->GetOption<uint32>("GameStateAPI.MaxQueuedRequests", 0);
+    _limits.KeepAliveMaxCount = sConfigMgr->GetOption<uint32>("GameStateAPI.KeepAliveMaxCount", 100);
+    _limits.KeepAliveTimeout = Seconds(sConfigMgr->GetOption<uint32>("GameStateAPI.KeepAliveTimeout", 5));
+    _limits.ReadTimeout = Seconds(sConfigMgr->GetOption<uint32>("GameStateAPI.ReadTimeout", 5));
+    _limits.WriteTimeout = Seconds(sConfigMgr->GetOption<uint32>("GameStateAPI.WriteTimeout", 5));
+    _limits.ReservedThreads = sConfigMgr->GetOption<uint32>("GameStateAPI.ReservedThreads", 1);
+    _limits.PlayerLaneThreads = sConfigMgr->GetOption<uint32>("GameStateAPI.PlayerLaneThreads", 0);
+    _limits.CollectionLaneThreads = sConfigMgr->GetOption<uint32>("GameStateAPI.CollectionLaneThreads", 0);
+    _limits.StreamLaneThreads = sConfigMgr->GetOption<uint32>("GameStateAPI.StreamLaneThreads", 0);
+
+    _limits.Listeners = std::max<uint32>(sConfigMgr->GetOption<uint32>("GameStateAPI.Listeners", 1), 1);
+    _limits.Cpus.clear();
+    std::string cpus = sConfigMgr->GetOption<std::string>("GameStateAPI.ListenerCpus", "");
+    if (!ParseCpuList(cpus, _limits.Cpus))
+    {
+        LOG_ERROR("module.gamestate_api", "Invalid GameStateAPI.ListenerCpus \"{}\", listeners are not pinned", cpus);
+        _limits.Cpus.clear();
+    }
+
+    std::string backend = sConfigMgr->GetOption<std::string>("GameStateAPI.Backend", "threads");
+    _limits.Epoll = backend == "epoll";
+    if (!_limits.Epoll && backend != "threads")
+        LOG_ERROR("module.gamestate_api", "Unknown GameStateAPI.Backend \"{}\", using \"threads\"", backend);
+
+    sGameStateSnapshotMgr->SetUpdateInterval(Milliseconds(_snapshotInterval));
 
     LOG_INFO("module.gamestate_api", "Game State API Module Configuration:");
     LOG_INFO("module.gamestate_api", "  Enabled: {}", _enabled ? "Yes" : "No");
@@ -33,6 +99,15 @@ void GameStateAPI::OnAfterConfigLoad(bool /*reload*/)
         LOG_INFO("module.gamestate_api", "  Host: {}", _host);
         LOG_INFO("module.gamestate_api", "  Port: {}", _port);
         LOG_INFO("module.gamestate_api", "  Allowed Origin: {}", _allowedOrigin);
+        LOG_INFO("module.gamestate_api", "  Snapshot Interval: {} ms", _snapshotInterval);
+        LOG_INFO("module.gamestate_api", "  Backend: {}", _limits.Epoll ? "epoll" : "threads");
+        LOG_INFO("module.gamestate_api", "  Listeners: {}, CPUs: {}", _limits.Listeners, _limits.Cpus.empty() ? "any" : cpus);
+        LOG_INFO("module.gamestate_api", "  Threads per listener: {}", _limits.Threads ? std::to_string(_limits.Threads) : "default");
+        LOG_INFO("module.gamestate_api", "  Max Queued Requests: {}", _limits.MaxQueuedRequests ? std::to_string(_limits.MaxQueuedRequests) : "unlimited");
+        LOG_INFO("module.gamestate_api", "  Keep-Alive: {} requests, {} s", _limits.KeepAliveMaxCount, _limits.KeepAliveTimeout.count());
+        LOG_INFO("module.gamestate_api", "  Read/Write Timeout: {} s / {} s", _limits.ReadTimeout.count(), _limits.WriteTimeout.count());
+        LOG_INFO("module.gamestate_api", "  Lanes: {} reserved, player {}, collection {}, stream {} (0 = shared)",
+            _limits.ReservedThreads, _limits.PlayerLaneThreads, _limits.CollectionLaneThreads, _limits.StreamLaneThreads);
     }
 }
 
@@ -46,7 +121,10 @@ void GameStateAPI::OnStartup()
 
     LOG_INFO("module.gamestate_api", "Starting Game State API HTTP Server...");
 
-    _httpServer = std::make_unique<HttpGameStateServer>(_host, _port, _allowedOrigin);
+    // Templates are loaded by now and stay immutable while the server runs
+    GameStateUtilities::InitializeTemplateCaches();
+
+    _httpServer = std::make_unique<HttpGameStateServer>(_host, _port, _allowedOrigin, _limits);
 
     if (_httpServer->Start())
     {
@@ -56,6 +134,7 @@ void GameStateAPI::OnStartup()
     {
         LOG_ERROR("module.gamestate_api", "Failed to start Game State API HTTP Server");
         _httpServer.reset();
+        GameStateUtilities::ClearTemplateCaches();
     }
 }
 
@@ -68,10 +147,40 @@ void GameStateAPI::OnShutdown()
         _httpServer.reset();
         LOG_INFO("module.gamestate_api", "Game State API HTTP Server stopped");
     }
+
+    sGameStateSnapshotMgr->Reset();
+    GameStateUtilities::ClearTemplateCaches();
+}
+
+void GameStateAPI::OnUpdate(uint32 diff)
+{
+    // Snapshots are only worth building while someone can read them
+    if (!_httpServer)
+        return;
+
+    sGameStateSnapshotMgr->Update(diff);
+}
+
+GameStateAPIPlayerScript::GameStateAPIPlayerScript() : PlayerScript("GameStateAPIPlayerScript", {
+    PLAYERHOOK_ON_LOGIN,
+    PLAYERHOOK_ON_LOGOUT
+})
+{
+}
+
+void GameStateAPIPlayerScript::OnPlayerLogin(Player* player)
+{
+    sGameStateSnapshotMgr->AddPlayerName(player);
+}
+
+void GameStateAPIPlayerScript::OnPlayerLogout(Player* player)
+{
+    sGameStateSnapshotMgr->RemovePlayerName(player);
 }
 
-// Register the script
+// Register the scripts
 void AddGameStateAPIScripts()
 {
     new GameStateAPI();
+    new GameStateAPIPlayerScript();
 }
@@ -7,11 +7,10 @@
 
 #include "ScriptMgr.h"
 #include "Config.h"
+#include "HttpGameStateServer.h"
 #include <string>
 #include <memory>
 
-class HttpGameStateServer;
-
 // Game State API Module
 class GameStateAPI : public WorldScript
 {
@@ -22,6 +21,7 @@ public:
     void OnAfterConfigLoad(bool reload) override;
     void OnStartup() override;
     void OnShutdown() override;
+    void OnUpdate(uint32 diff) override;
 
 private:
     std::unique_ptr<HttpGameStateServer> _httpServer;
@@ -29,6 +29,19 @@ private:
     std::string _host;
     uint16 _port;
     std::string _allowedOrigin;
+    uint32 _snapshotInterval;
+    HttpServerLimits _limits;
+};
+
+// Keeps the snapshot manager's name index current as players log in and out,
+// so HTTP lookups by name never go through ObjectAccessor
+class GameStateAPIPlayerScript : public PlayerScript
+{
+public:
+    GameStateAPIPlayerScript();
+
+    void OnPlayerLogin(Player* player) override;
+    void OnPlayerLogout(Player* player) override;
 };
 
 #endif // GAME_STATE_API_H
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "GameStateCompression.h"
+#include "Log.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <zlib.h>
+
+#ifdef GAMESTATE_API_ZSTD
+#include <zstd.h>
+#endif
+
+namespace
+{
+    std::string_view Trim(std::string_view text)
+    {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+            text.remove_prefix(1);
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+            text.remove_suffix(1);
+        return text;
+    }
+
+    // q-value in thousandths, so "q=0.5" is 500 and a missing q is 1000
+    int32 ParseQuality(std::string_view params)
+    {
+        while (!params.empty())
+        {
+            std::size_t end = params.find(';');
+            std::string_view param = Trim(params.substr(0, end));
+            params = end == std::string_view::npos ? std::string_view() : params.substr(end + 1);
+
+            if (param.size() < 2 || (param[0] != 'q' && param[0] != 'Q') || param[1] != '=')
+                continue;
+
+            std::string_view value = param.substr(2);
+            int32 quality = 0;
+            std::size_t dot = value.find('.');
+            std::from_chars(value.data(), value.data() + std::min(dot, value.size()), quality);
+            quality *= 1000;
+
+            if (dot != std::string_view::npos)
+            {
+                int32 scale = 100;
+                for (std::size_t i = dot + 1; i < value.size() && scale; ++i, scale /= 10)
+                    if (value[i] >= '0' && value[i] <= '9')
+                        quality += (value[i] - '0') * scale;
+            }
+
+            return std::clamp(quality, 0, 1000);
+        }
+
+        return 1000;
+    }
+
+    bool CompressGzip(std::string_view input, std::string& output)
+    {
+        z_stream stream = { };
+        // 15 window bits plus 16 selects the gzip wrapper instead of zlib's
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            return false;
+
+        output.resize(deflateBound(&stream, static_cast<uLong>(input.size())));
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        stream.avail_in = static_cast<uInt>(input.size());
+        stream.next_out = reinterpret_cast<Bytef*>(output.data());
+        stream.avail_out = static_cast<uInt>(output.size());
+
+        int result = deflate(&stream, Z_FINISH);
+        output.resize(stream.total_out);
+        deflateEnd(&stream);
+        return result == Z_STREAM_END;
+    }
+
+#ifdef GAMESTATE_API_ZSTD
+    bool CompressZstd(std::string_view input, std::string& output)
+    {
+        output.resize(ZSTD_compressBound(input.size()));
+        std::size_t size = ZSTD_compress(output.data(), output.size(), input.data(), input.size(), ZSTD_CLEVEL_DEFAULT);
+        if (ZSTD_isError(size))
+            return false;
+
+        output.resize(size);
+        return true;
+    }
+#endif
+}
+
+void GameStateCompression::ParseHeaderList(std::string_view header, std::function<void(std::string_view name, int32 quality)> const& visit)
+{
+    while (!header.empty())
+    {
+        std::size_t end = header.find(',');
+        std::string_view entry = header.substr(0, end);
+        header = end == std::string_view::npos ? std::string_view() : header.substr(end + 1);
+
+        std::size_t params = entry.find(';');
+        std::string_view name = Trim(entry.substr(0, params));
+        if (!name.empty())
+            visit(name, params == std::string_view::npos ? 1000 : ParseQuality(entry.substr(params + 1)));
+    }
+}
+
+bool GameStateCompression::EqualsIgnoreCase(std::string_view a, std::string_view b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](char x, char y)
+    {
+        return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+    });
+}
+
+GameStateEncoding GameStateCompression::Negotiate(std::string const& acceptEncoding)
+{
+    int32 gzip = -1;
+    int32 zstd = -1;
+    int32 any = -1;
+
+    ParseHeaderList(acceptEncoding, [&](std::string_view name, int32 quality)
+    {
+        if (EqualsIgnoreCase(name, "gzip") || EqualsIgnoreCase(name, "x-gzip"))
+            gzip = quality;
+        else if (EqualsIgnoreCase(name, "zstd"))
+            zstd = quality;
+        else if (name == "*")
+            any = quality;
+    });
+
+    // "*" covers whatever was not listed explicitly
+    if (gzip < 0)
+        gzip = any;
+    if (zstd < 0)
+        zstd = any;
+
+#ifdef GAMESTATE_API_ZSTD
+    // zstd wins ties, it is both smaller and faster than gzip
+    if (zstd > 0 && zstd >= gzip)
+        return GameStateEncoding::Zstd;
+#endif
+
+    if (gzip > 0)
+        return GameStateEncoding::Gzip;
+
+    return GameStateEncoding::Identity;
+}
+
+std::string_view GameStateCompression::GetName(GameStateEncoding encoding)
+{
+    switch (encoding)
+    {
+        case GameStateEncoding::Gzip:
+            return "gzip";
+        case GameStateEncoding::Zstd:
+            return "zstd";
+        default:
+            return { };
+    }
+}
+
+bool GameStateCompression::Compress(std::string_view input, GameStateEncoding encoding, std::string& output)
+{
+    bool compressed = false;
+    switch (encoding)
+    {
+        case GameStateEncoding::Gzip:
+            compressed = CompressGzip(input, output);
+            break;
+#ifdef GAMESTATE_API_ZSTD
+        case GameStateEncoding::Zstd:
+            compressed = CompressZstd(input, output);
+            break;
+#endif
+        default:
+            break;
+    }
+
+    if (!compressed && encoding != GameStateEncoding::Identity)
+        LOG_ERROR("module.gamestate_api", "Failed to compress {} byte response with {}", input.size(), GetName(encoding));
+
+    return compressed;
+}
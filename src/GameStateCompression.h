@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_GAMESTATECOMPRESSION_H
+#define GAMESTATEAPI_GAMESTATECOMPRESSION_H
+
+#include "Define.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+enum class GameStateEncoding : uint8
+{
+    Identity,
+    Gzip,
+    Zstd // only negotiated when built with GAMESTATE_API_ZSTD
+};
+
+// Bodies smaller than this are sent uncompressed, the headers would cost more
+// than compression saves
+static constexpr std::size_t GAME_STATE_COMPRESSION_MIN_SIZE = 1024;
+
+namespace GameStateCompression
+{
+    // Calls visit for every entry of a comma separated header such as Accept
+    // or Accept-Encoding, with its q-value in thousandths (1000 when absent)
+    void ParseHeaderList(std::string_view header, std::function<void(std::string_view name, int32 quality)> const& visit);
+    bool EqualsIgnoreCase(std::string_view a, std::string_view b);
+
+    // Picks the best supported encoding from an Accept-Encoding header,
+    // honouring q-values ("gzip;q=0" or "*;q=0" rule an encoding out)
+    GameStateEncoding Negotiate(std::string const& acceptEncoding);
+
+    // Content-Encoding token, empty for Identity
+    std::string_view GetName(GameStateEncoding encoding);
+
+    // Replaces output with input compressed as encoding; false on failure
+    bool Compress(std::string_view input, GameStateEncoding encoding, std::string& output);
+}
+
+#endif // GAMESTATEAPI_GAMESTATECOMPRESSION_H
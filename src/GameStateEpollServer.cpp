@@ -0,0 +1,854 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifdef __linux__
+
+#include "GameStateEpollServer.h"
+#include "GameStateSnapshot.h"
+#include "Log.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <set>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// epoll_event ids of the two descriptors that are not connections
+static constexpr uint64 EPOLL_LISTENER_ID = 0;
+static constexpr uint64 EPOLL_WAKE_ID = 1;
+
+static constexpr int EPOLL_MAX_EVENTS = 256;
+
+// How often the reactor wakes up to close idle connections
+static constexpr int EPOLL_SWEEP_INTERVAL_MS = 1000;
+
+// Largest request head and body a connection may send
+static constexpr std::size_t EPOLL_MAX_HEADER_SIZE = 8 * 1024;
+static constexpr std::size_t EPOLL_MAX_BODY_SIZE = 1024 * 1024;
+
+// Stream subscribers with this many events not yet fully written (5 seconds
+// of snapshots at the default interval) are too slow to keep up and get
+// disconnected, rather than buffering events for them indefinitely. Events
+// are counted rather than bytes: the first one is a full snapshot, which on
+// a busy realm is large on its own.
+static constexpr std::size_t EPOLL_MAX_STREAM_PENDING_EVENTS = 50;
+
+// Written output is only compacted away once it gets this large
+static constexpr std::size_t EPOLL_OUTPUT_COMPACT_SIZE = 64 * 1024;
+
+struct GameStateEpollServer::Connection
+{
+    enum class State
+    {
+        Reading,    // waiting for (the rest of) a request
+        Dispatched, // a worker is handling the request
+        Streaming   // an event stream is open, only written to
+    };
+
+    int Fd = -1;
+    State Status = State::Reading;
+    uint32 Events = 0; // currently registered with epoll
+    std::string Input;
+    std::string Output;
+    std::size_t OutputOffset = 0;
+    uint32 Served = 0;
+    bool CloseAfterWrite = false;
+    bool InputClosed = false;  // the client shut down its side, nothing more will be read
+    bool ContinueSent = false; // 100 Continue already answered for the request being read
+    std::chrono::steady_clock::time_point LastActivity;
+
+    // Bytes ever queued and written, and where each stream event not yet
+    // fully written ends in that count
+    uint64 Queued = 0;
+    uint64 Written = 0;
+    std::deque<uint64> PendingEvents;
+};
+
+// Bodyless response for requests rejected before they reach a handler
+static std::string MakeErrorResponse(int status)
+{
+    return "HTTP/1.1 " + std::to_string(status) + " " + httplib::status_message(status) + "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+}
+
+static std::string MakeChunk(std::string const& data)
+{
+    char size[17];
+    std::to_chars_result result = std::to_chars(size, size + sizeof(size), data.size(), 16);
+    std::string chunk(size, result.ptr);
+    chunk.append("\r\n").append(data).append("\r\n");
+    return chunk;
+}
+
+static std::string_view TrimHeaderValue(std::string_view value)
+{
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+        value.remove_prefix(1);
+
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+        value.remove_suffix(1);
+
+    return value;
+}
+
+// Parse the request line and headers of head (without the final empty line)
+static bool ParseRequestHead(std::string_view head, httplib::Request& req)
+{
+    static std::set<std::string> const Methods = { "GET", "HEAD", "POST", "PUT", "DELETE", "OPTIONS", "PATCH" };
+
+    std::size_t lineEnd = head.find("\r\n");
+    std::string_view line = head.substr(0, lineEnd);
+
+    std::size_t methodEnd = line.find(' ');
+    std::size_t targetEnd = methodEnd == std::string_view::npos ? methodEnd : line.find(' ', methodEnd + 1);
+    if (targetEnd == std::string_view::npos)
+        return false;
+
+    req.method = line.substr(0, methodEnd);
+    req.target = line.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+    req.version = line.substr(targetEnd + 1);
+    if (!Methods.count(req.method) || (req.version != "HTTP/1.1" && req.version != "HTTP/1.0"))
+        return false;
+
+    while (lineEnd != std::string_view::npos)
+    {
+        std::size_t start = lineEnd + 2;
+        lineEnd = head.find("\r\n", start);
+        line = head.substr(start, lineEnd == std::string_view::npos ? std::string_view::npos : lineEnd - start);
+
+        std::size_t colon = line.find(':');
+        if (colon == std::string_view::npos || colon == 0)
+            return false;
+
+        req.headers.emplace(std::string(line.substr(0, colon)), std::string(TrimHeaderValue(line.substr(colon + 1))));
+    }
+
+    std::string target = req.target.substr(0, req.target.find('#'));
+    std::size_t query = target.find('?');
+    req.path = httplib::detail::decode_path(target.substr(0, query), false);
+    if (query != std::string::npos)
+        httplib::detail::parse_query_text(target.data() + query + 1, target.size() - query - 1, req.params);
+
+    return true;
+}
+
+GameStateEpollServer::GameStateEpollServer(HttpServerLimits const& limits, std::vector<uint32> cpus, Dispatcher dispatcher)
+    : _limits(limits), _cpus(std::move(cpus)), _dispatcher(std::move(dispatcher)), _listenFd(-1), _epollFd(-1), _wakeFd(-1),
+    _stopping(false), _acceptPaused(false), _nextId(EPOLL_WAKE_ID + 1)
+{
+}
+
+GameStateEpollServer::~GameStateEpollServer()
+{
+    Stop();
+}
+
+bool GameStateEpollServer::Start(std::string const& host, uint16 port)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+
+    addrinfo* addresses = nullptr;
+    if (int error = getaddrinfo(host.empty() ? nullptr : host.c_str(), std::to_string(port).c_str(), &hints, &addresses))
+    {
+        LOG_ERROR("module.gamestate_api", "Cannot resolve {}: {}", host, gai_strerror(error));
+        return false;
+    }
+
+    for (addrinfo* address = addresses; address && _listenFd < 0; address = address->ai_next)
+    {
+        int fd = socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, address->ai_protocol);
+        if (fd < 0)
+            continue;
+
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse));
+        if (bind(fd, address->ai_addr, address->ai_addrlen) == 0 && listen(fd, SOMAXCONN) == 0)
+            _listenFd = fd;
+        else
+            close(fd);
+    }
+
+    freeaddrinfo(addresses);
+
+    if (_listenFd < 0)
+    {
+        LOG_ERROR("module.gamestate_api", "Cannot listen on {}:{}: {}", host, port, std::strerror(errno));
+        return false;
+    }
+
+    _epollFd = epoll_create1(EPOLL_CLOEXEC);
+    _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_epollFd < 0 || _wakeFd < 0)
+    {
+        LOG_ERROR("module.gamestate_api", "Cannot create epoll reactor: {}", std::strerror(errno));
+        Stop();
+        return false;
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = EPOLL_LISTENER_ID;
+    epoll_ctl(_epollFd, EPOLL_CTL_ADD, _listenFd, &event);
+    event.data.u64 = EPOLL_WAKE_ID;
+    epoll_ctl(_epollFd, EPOLL_CTL_ADD, _wakeFd, &event);
+
+    std::size_t threads = _limits.Threads ? _limits.Threads : CPPHTTPLIB_THREAD_POOL_COUNT;
+    _workers = std::make_unique<GameStateTaskQueue>(threads, _limits.MaxQueuedRequests, _cpus);
+
+    _stopping.store(false);
+    _reactorThread = std::thread([this]()
+    {
+        GameStateTaskQueue::PinCurrentThread(_cpus);
+        RunReactor();
+    });
+
+    _streamThread = std::thread([this]()
+    {
+        GameStateTaskQueue::PinCurrentThread(_cpus);
+        RunStreams();
+    });
+    return true;
+}
+
+void GameStateEpollServer::Stop()
+{
+    _stopping.store(true);
+
+    if (_reactorThread.joinable())
+    {
+        uint64 wake = 1;
+        [[maybe_unused]] ssize_t written = write(_wakeFd, &wake, sizeof(wake));
+        _reactorThread.join();
+    }
+
+    // Workers still finishing a request post to the wake descriptor, so it
+    // stays open until they are done
+    if (_workers)
+    {
+        _workers->shutdown();
+        _workers.reset();
+    }
+
+    if (_streamThread.joinable())
+        _streamThread.join();
+
+    for (int* fd : { &_listenFd, &_epollFd, &_wakeFd })
+    {
+        if (*fd >= 0)
+            close(*fd);
+        *fd = -1;
+    }
+
+    _completions.clear();
+    _subscribers.clear();
+    _closedSubscribers.clear();
+}
+
+void GameStateEpollServer::RunReactor()
+{
+    std::array<epoll_event, EPOLL_MAX_EVENTS> events;
+    std::chrono::steady_clock::time_point lastSweep = std::chrono::steady_clock::now();
+
+    while (!_stopping.load())
+    {
+        int count = epoll_wait(_epollFd, events.data(), EPOLL_MAX_EVENTS, EPOLL_SWEEP_INTERVAL_MS);
+        if (count < 0 && errno != EINTR)
+        {
+            LOG_ERROR("module.gamestate_api", "epoll_wait failed: {}", std::strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            uint64 id = events[i].data.u64;
+            if (id == EPOLL_LISTENER_ID)
+            {
+                Accept();
+                continue;
+            }
+
+            if (id == EPOLL_WAKE_ID)
+            {
+                uint64 value;
+                [[maybe_unused]] ssize_t received = read(_wakeFd, &value, sizeof(value));
+                ProcessCompletions();
+                continue;
+            }
+
+            // Connections closed earlier in this round can still have events
+            auto itr = _connections.find(id);
+            if (itr == _connections.end())
+                continue;
+
+            Connection& connection = *itr->second;
+            uint32 ready = events[i].events;
+            if (ready & (EPOLLERR | EPOLLHUP))
+            {
+                CloseConnection(id);
+                continue;
+            }
+
+            // A client half-closing while its request is handled still gets
+            // the response; one leaving an open stream is gone
+            if ((ready & EPOLLRDHUP) && connection.Status == Connection::State::Dispatched)
+            {
+                connection.InputClosed = true;
+                UpdateEvents(id, connection);
+                continue;
+            }
+
+            if ((ready & EPOLLRDHUP) && connection.Status == Connection::State::Streaming)
+            {
+                CloseConnection(id);
+                continue;
+            }
+
+            if ((ready & EPOLLIN) && !OnReadable(id, connection))
+                continue;
+
+            if (ready & EPOLLOUT)
+                Flush(id, connection);
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now - lastSweep >= Milliseconds(EPOLL_SWEEP_INTERVAL_MS))
+        {
+            CloseIdleConnections(now);
+            lastSweep = now;
+        }
+    }
+
+    while (!_connections.empty())
+        CloseConnection(_connections.begin()->first);
+}
+
+void GameStateEpollServer::Accept()
+{
+    for (;;)
+    {
+        int fd = accept4(_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+
+            // Out of descriptors: stop accepting until the next sweep instead
+            // of spinning on a listener that stays readable
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                LOG_WARN("module.gamestate_api", "Cannot accept connection: {}", std::strerror(errno));
+                epoll_event event = {};
+                event.data.u64 = EPOLL_LISTENER_ID;
+                epoll_ctl(_epollFd, EPOLL_CTL_MOD, _listenFd, &event);
+                _acceptPaused = true;
+            }
+
+            return;
+        }
+
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        std::unique_ptr<Connection> connection = std::make_unique<Connection>();
+        connection->Fd = fd;
+        connection->Events = EPOLLIN | EPOLLRDHUP;
+        connection->LastActivity = std::chrono::steady_clock::now();
+
+        uint64 id = _nextId++;
+        epoll_event event = {};
+        event.events = connection->Events;
+        event.data.u64 = id;
+        if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event) < 0)
+        {
+            close(fd);
+            continue;
+        }
+
+        _connections.emplace(id, std::move(connection));
+    }
+}
+
+bool GameStateEpollServer::OnReadable(uint64 id, Connection& connection)
+{
+    char buffer[16 * 1024];
+    for (;;)
+    {
+        ssize_t received = recv(connection.Fd, buffer, sizeof(buffer), 0);
+        if (received > 0)
+        {
+            connection.Input.append(buffer, received);
+            connection.LastActivity = std::chrono::steady_clock::now();
+            if (connection.Input.size() > EPOLL_MAX_HEADER_SIZE + EPOLL_MAX_BODY_SIZE)
+            {
+                CloseConnection(id);
+                return false;
+            }
+
+            continue;
+        }
+
+        if (received < 0 && errno == EINTR)
+            continue;
+
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+
+        if (received < 0)
+        {
+            CloseConnection(id);
+            return false;
+        }
+
+        // Half-closed by the client: a request it sent before is still
+        // answered, then the connection is closed
+        connection.InputClosed = true;
+        break;
+    }
+
+    if (!ParseRequest(id, connection))
+        return false;
+
+    if (connection.InputClosed && connection.Status == Connection::State::Reading)
+    {
+        CloseConnection(id);
+        return false;
+    }
+
+    return true;
+}
+
+bool GameStateEpollServer::ParseRequest(uint64 id, Connection& connection)
+{
+    if (connection.Status != Connection::State::Reading || connection.Input.empty())
+        return true;
+
+    std::size_t headEnd = connection.Input.find("\r\n\r\n");
+    if (headEnd == std::string::npos && connection.Input.size() <= EPOLL_MAX_HEADER_SIZE)
+        return true;
+
+    if (headEnd == std::string::npos || headEnd > EPOLL_MAX_HEADER_SIZE)
+        return Reject(id, connection, 431);
+
+    std::shared_ptr<httplib::Request> req = std::make_shared<httplib::Request>();
+    if (!ParseRequestHead(std::string_view(connection.Input).substr(0, headEnd), *req))
+        return Reject(id, connection, 400);
+
+    // Request bodies are only needed by POST /api/batch, which clients send
+    // with a Content-Length
+    if (req->has_header("Transfer-Encoding"))
+        return Reject(id, connection, 411);
+
+    std::size_t length = 0;
+    if (req->has_header("Content-Length"))
+    {
+        std::string value = req->get_header_value("Content-Length");
+        std::from_chars_result result = std::from_chars(value.data(), value.data() + value.size(), length);
+        if (value.empty() || result.ec != std::errc() || result.ptr != value.data() + value.size())
+            return Reject(id, connection, 400);
+
+        if (length > EPOLL_MAX_BODY_SIZE)
+            return Reject(id, connection, 413);
+    }
+
+    std::size_t bodyStart = headEnd + 4;
+    if (connection.Input.size() - bodyStart < length)
+    {
+        // Clients such as curl hold larger bodies back until told to go on
+        if (!connection.ContinueSent && req->version == "HTTP/1.1"
+            && httplib::detail::case_ignore::equal(req->get_header_value("Expect"), "100-continue"))
+        {
+            static constexpr std::string_view Continue = "HTTP/1.1 100 Continue\r\n\r\n";
+            connection.ContinueSent = true;
+            connection.Output.append(Continue);
+            connection.Queued += Continue.size();
+            return Flush(id, connection);
+        }
+
+        return true;
+    }
+
+    req->body = connection.Input.substr(bodyStart, length);
+    connection.Input.erase(0, bodyStart + length);
+    connection.ContinueSent = false;
+
+    std::string keepAlive = req->get_header_value("Connection");
+    bool close = req->version == "HTTP/1.0" ? !httplib::detail::case_ignore::equal(keepAlive, "keep-alive")
+        : httplib::detail::case_ignore::equal(keepAlive, "close");
+    if (connection.InputClosed)
+        close = true;
+    if (++connection.Served >= std::max<uint32>(_limits.KeepAliveMaxCount, 1))
+        close = true;
+
+    connection.Status = Connection::State::Dispatched;
+    UpdateEvents(id, connection);
+
+    // A connection turned away here is dropped, the shedding backlog is full too
+    if (!_workers->enqueue([this, id, req, close]()
+    {
+        std::vector<Completion> completions;
+        completions.push_back(Execute(id, *req, close));
+        Post(completions);
+    }))
+    {
+        CloseConnection(id);
+        return false;
+    }
+
+    return true;
+}
+
+bool GameStateEpollServer::Reject(uint64 id, Connection& connection, int status)
+{
+    connection.Status = Connection::State::Dispatched;
+    connection.Input.clear();
+    connection.Output.append(MakeErrorResponse(status));
+    connection.CloseAfterWrite = true;
+    return Flush(id, connection);
+}
+
+GameStateEpollServer::Completion GameStateEpollServer::Execute(uint64 id, httplib::Request& req, bool close)
+{
+    Completion completion;
+    completion.Id = id;
+
+    httplib::Response res;
+    std::string body;
+    try
+    {
+        _dispatcher(req, res, completion.Stream);
+
+        // Providers of buffered responses are driven right here, only event
+        // streams are written as they go
+        if (res.content_provider_ && !res.is_chunked_content_provider_)
+        {
+            httplib::DataSink sink;
+            sink.write = [&body](char const* data, std::size_t length) { body.append(data, length); return true; };
+            sink.is_writable = []() { return true; };
+            sink.done = []() { };
+
+            while (body.size() < res.content_length_)
+            {
+                std::size_t offset = body.size();
+                if (!res.content_provider_(offset, res.content_length_ - offset, sink) || body.size() == offset)
+                    throw std::runtime_error("content provider failed");
+            }
+
+            res.content_provider_success_ = true;
+        }
+        else
+            body = std::move(res.body);
+    }
+    catch (std::exception const& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error handling {} {}: {}", req.method, req.path, e.what());
+        res.status = 500;
+        res.headers.clear();
+        body.clear();
+        completion.Stream.reset();
+    }
+
+    if (res.status == -1)
+        res.status = 404;
+
+    // A response without a body must not turn into an event stream
+    if (req.method == "HEAD")
+        completion.Stream.reset();
+
+    close = close || httplib::detail::case_ignore::equal(res.get_header_value("Connection"), "close");
+    completion.Close = close && !completion.Stream;
+
+    std::string& data = completion.Data;
+    data.append("HTTP/1.1 ").append(std::to_string(res.status)).append(" ").append(httplib::status_message(res.status)).append("\r\n");
+    for (auto const& [name, value] : res.headers)
+    {
+        if (httplib::detail::case_ignore::equal(name, "Connection") || httplib::detail::case_ignore::equal(name, "Keep-Alive")
+            || httplib::detail::case_ignore::equal(name, "Content-Length"))
+            continue;
+
+        data.append(name).append(": ").append(value).append("\r\n");
+    }
+
+    if (!body.empty() && !res.has_header("Content-Type"))
+        data.append("Content-Type: text/plain\r\n");
+
+    if (completion.Stream)
+        data.append("Transfer-Encoding: chunked\r\n");
+    else
+        data.append("Content-Length: ").append(std::to_string(body.size())).append("\r\n");
+
+    if (completion.Close)
+        data.append("Connection: close\r\n");
+    else
+    {
+        data.append("Connection: keep-alive\r\n");
+        data.append("Keep-Alive: timeout=").append(std::to_string(_limits.KeepAliveTimeout.count()))
+            .append(", max=").append(std::to_string(_limits.KeepAliveMaxCount)).append("\r\n");
+    }
+
+    data.append("\r\n");
+    if (req.method != "HEAD")
+        data.append(body);
+
+    return completion;
+}
+
+void GameStateEpollServer::Post(std::vector<Completion>& completions)
+{
+    if (completions.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_completionLock);
+        for (Completion& completion : completions)
+            _completions.push_back(std::move(completion));
+    }
+
+    completions.clear();
+
+    uint64 wake = 1;
+    [[maybe_unused]] ssize_t written = write(_wakeFd, &wake, sizeof(wake));
+}
+
+void GameStateEpollServer::ProcessCompletions()
+{
+    std::vector<Completion> completions;
+    {
+        std::lock_guard<std::mutex> lock(_completionLock);
+        completions.swap(_completions);
+    }
+
+    for (Completion& completion : completions)
+    {
+        auto itr = _connections.find(completion.Id);
+        if (itr == _connections.end())
+            continue;
+
+        Connection& connection = *itr->second;
+        if (connection.Status == Connection::State::Streaming)
+        {
+            while (!connection.PendingEvents.empty() && connection.PendingEvents.front() <= connection.Written)
+                connection.PendingEvents.pop_front();
+
+            if (connection.PendingEvents.size() >= EPOLL_MAX_STREAM_PENDING_EVENTS)
+            {
+                CloseConnection(completion.Id);
+                continue;
+            }
+
+            connection.PendingEvents.push_back(connection.Queued + completion.Data.size());
+            connection.CloseAfterWrite = completion.Close;
+        }
+
+        connection.Output.append(completion.Data);
+        connection.Queued += completion.Data.size();
+        connection.LastActivity = std::chrono::steady_clock::now();
+
+        if (completion.Stream)
+        {
+            connection.Status = Connection::State::Streaming;
+
+            std::lock_guard<std::mutex> lock(_streamLock);
+            _subscribers.push_back({ completion.Id, std::move(completion.Stream) });
+        }
+        else if (connection.Status != Connection::State::Streaming)
+        {
+            connection.Status = Connection::State::Reading;
+            connection.CloseAfterWrite = completion.Close || connection.InputClosed;
+        }
+
+        // Pipelined requests are handled once this response is on its way
+        if (Flush(completion.Id, connection) && !connection.CloseAfterWrite)
+            ParseRequest(completion.Id, connection);
+    }
+}
+
+bool GameStateEpollServer::Flush(uint64 id, Connection& connection)
+{
+    while (connection.OutputOffset < connection.Output.size())
+    {
+        ssize_t sent = send(connection.Fd, connection.Output.data() + connection.OutputOffset,
+            connection.Output.size() - connection.OutputOffset, MSG_NOSIGNAL);
+        if (sent > 0)
+        {
+            connection.OutputOffset += sent;
+            connection.Written += sent;
+            connection.LastActivity = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        if (sent < 0 && errno == EINTR)
+            continue;
+
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+
+        CloseConnection(id);
+        return false;
+    }
+
+    if (connection.OutputOffset == connection.Output.size())
+    {
+        connection.Output.clear();
+        connection.OutputOffset = 0;
+        if (connection.CloseAfterWrite)
+        {
+            CloseConnection(id);
+            return false;
+        }
+    }
+    else if (connection.OutputOffset >= EPOLL_OUTPUT_COMPACT_SIZE)
+    {
+        connection.Output.erase(0, connection.OutputOffset);
+        connection.OutputOffset = 0;
+    }
+
+    UpdateEvents(id, connection);
+    return true;
+}
+
+void GameStateEpollServer::UpdateEvents(uint64 id, Connection& connection)
+{
+    // A half-closed socket stays readable, it is no longer watched for input
+    uint32 events = connection.InputClosed ? 0u : uint32(EPOLLRDHUP);
+    if (connection.Status == Connection::State::Reading && !connection.InputClosed)
+        events |= EPOLLIN;
+
+    if (connection.OutputOffset < connection.Output.size())
+        events |= EPOLLOUT;
+
+    if (events == connection.Events)
+        return;
+
+    epoll_event event = {};
+    event.events = events;
+    event.data.u64 = id;
+    epoll_ctl(_epollFd, EPOLL_CTL_MOD, connection.Fd, &event);
+    connection.Events = events;
+}
+
+void GameStateEpollServer::CloseConnection(uint64 id)
+{
+    auto itr = _connections.find(id);
+    if (itr == _connections.end())
+        return;
+
+    Connection& connection = *itr->second;
+    epoll_ctl(_epollFd, EPOLL_CTL_DEL, connection.Fd, nullptr);
+    close(connection.Fd);
+
+    if (connection.Status == Connection::State::Streaming)
+    {
+        std::lock_guard<std::mutex> lock(_streamLock);
+        _closedSubscribers.push_back(id);
+    }
+
+    _connections.erase(itr);
+}
+
+void GameStateEpollServer::CloseIdleConnections(std::chrono::steady_clock::time_point now)
+{
+    if (_acceptPaused)
+    {
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = EPOLL_LISTENER_ID;
+        epoll_ctl(_epollFd, EPOLL_CTL_MOD, _listenFd, &event);
+        _acceptPaused = false;
+    }
+
+    std::vector<uint64> idle;
+    for (auto const& [id, connection] : _connections)
+    {
+        std::chrono::steady_clock::duration inactive = now - connection->LastActivity;
+        if (connection->OutputOffset < connection->Output.size())
+        {
+            if (inactive > _limits.WriteTimeout)
+                idle.push_back(id);
+        }
+        else if (connection->Status == Connection::State::Reading)
+        {
+            if (inactive > (connection->Input.empty() ? _limits.KeepAliveTimeout : _limits.ReadTimeout))
+                idle.push_back(id);
+        }
+    }
+
+    for (uint64 id : idle)
+        CloseConnection(id);
+}
+
+void GameStateEpollServer::RunStreams()
+{
+    uint64 seenVersion = 0;
+    std::vector<Subscriber> subscribers;
+    std::vector<Completion> completions;
+
+    while (!_stopping.load())
+    {
+        std::set<uint32> fields;
+        {
+            std::lock_guard<std::mutex> lock(_streamLock);
+            if (!_closedSubscribers.empty())
+            {
+                std::sort(_closedSubscribers.begin(), _closedSubscribers.end());
+                std::erase_if(_subscribers, [this](Subscriber const& subscriber)
+                {
+                    return std::binary_search(_closedSubscribers.begin(), _closedSubscribers.end(), subscriber.Id);
+                });
+                _closedSubscribers.clear();
+            }
+
+            subscribers = _subscribers;
+        }
+
+        // Keeps the sections the open streams send captured
+        for (Subscriber const& subscriber : subscribers)
+            fields.insert(subscriber.Stream->GetFields());
+
+        for (uint32 requested : fields)
+            sGameStateSnapshotMgr->RequestPlayerFields(requested);
+
+        GameStateSnapshotPtr snapshot = sGameStateSnapshotMgr->WaitForSnapshot(seenVersion, GAME_STATE_STREAM_WAIT_TIMEOUT);
+        if (!snapshot)
+        {
+            // The world is shutting down: end the open streams
+            {
+                std::lock_guard<std::mutex> lock(_streamLock);
+                for (Subscriber const& subscriber : _subscribers)
+                    completions.push_back({ subscriber.Id, "0\r\n\r\n", true, nullptr });
+                _subscribers.clear();
+            }
+
+            Post(completions);
+            std::this_thread::sleep_for(GAME_STATE_STREAM_WAIT_TIMEOUT);
+            continue;
+        }
+
+        seenVersion = snapshot->Version;
+
+        // Subscribers at the same position share one rendering of the event
+        GameStateStream::EventCache cache;
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        for (Subscriber const& subscriber : subscribers)
+        {
+            std::string event = subscriber.Stream->NextEvent(*snapshot, now, &cache);
+            if (!event.empty())
+                completions.push_back({ subscriber.Id, MakeChunk(event), false, nullptr });
+        }
+
+        Post(completions);
+    }
+}
+
+#endif // __linux__
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_GAMESTATEEPOLLSERVER_H
+#define GAMESTATEAPI_GAMESTATEEPOLLSERVER_H
+
+#ifdef __linux__
+
+#include "Define.h"
+#include "GameStateStream.h"
+#include "GameStateTaskQueue.h"
+#include "HttpGameStateServer.h"
+#include <yhirose/httplib.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Event-driven HTTP/1.1 backend (GameStateAPI.Backend = "epoll"). A single
+// reactor thread owns every connection and only reads, parses and writes;
+// requests run on a GameStateTaskQueue and their serialized responses are
+// handed back to the reactor. Open /api/stream connections cost no thread at
+// all: one stream thread renders each snapshot's events for every subscriber.
+class GameStateEpollServer
+{
+public:
+    // Runs a parsed request through the API's handlers. A handler opening an
+    // event stream stores it in stream instead of setting a content provider.
+    using Dispatcher = std::function<void(httplib::Request& req, httplib::Response& res, std::shared_ptr<GameStateStream>& stream)>;
+
+    // All of its threads run on cpus, unless it is empty
+    GameStateEpollServer(HttpServerLimits const& limits, std::vector<uint32> cpus, Dispatcher dispatcher);
+    ~GameStateEpollServer();
+
+    // Binds host:port and starts the reactor, stream and worker threads. The
+    // port is bound with SO_REUSEPORT, so several instances can share it.
+    bool Start(std::string const& host, uint16 port);
+    void Stop();
+
+private:
+    struct Connection;
+
+    // Result of a request or a stream event, for the reactor to write
+    struct Completion
+    {
+        uint64 Id = 0;
+        std::string Data;
+        bool Close = false;
+        std::shared_ptr<GameStateStream> Stream; // set when the response opened a stream
+    };
+
+    struct Subscriber
+    {
+        uint64 Id;
+        std::shared_ptr<GameStateStream> Stream;
+    };
+
+    void RunReactor();
+    void RunStreams();
+
+    // Reactor thread. Functions returning bool return false once they
+    // closed the connection.
+    void Accept();
+    bool OnReadable(uint64 id, Connection& connection);
+    bool ParseRequest(uint64 id, Connection& connection);
+    bool Reject(uint64 id, Connection& connection, int status);
+    bool Flush(uint64 id, Connection& connection);
+    void UpdateEvents(uint64 id, Connection& connection);
+    void CloseConnection(uint64 id);
+    void CloseIdleConnections(std::chrono::steady_clock::time_point now);
+    void ProcessCompletions();
+
+    // Hand completions to the reactor and wake it up
+    void Post(std::vector<Completion>& completions);
+
+    // Run on a worker: dispatch and serialize the response
+    Completion Execute(uint64 id, httplib::Request& req, bool close);
+
+    HttpServerLimits _limits;
+    std::vector<uint32> _cpus;
+    Dispatcher _dispatcher;
+
+    int _listenFd;
+    int _epollFd;
+    int _wakeFd;
+
+    std::atomic<bool> _stopping;
+    bool _acceptPaused;
+    std::unique_ptr<GameStateTaskQueue> _workers;
+    std::thread _reactorThread;
+    std::thread _streamThread;
+
+    // Owned by the reactor thread
+    std::unordered_map<uint64, std::unique_ptr<Connection>> _connections;
+    uint64 _nextId;
+
+    std::mutex _completionLock;
+    std::vector<Completion> _completions;
+
+    // Streams opened on the reactor thread, served by the stream thread
+    std::mutex _streamLock;
+    std::vector<Subscriber> _subscribers;
+    std::vector<uint64> _closedSubscribers;
+};
+
+#endif // __linux__
+
+#endif // GAMESTATEAPI_GAMESTATEEPOLLSERVER_H
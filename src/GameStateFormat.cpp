@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "GameStateFormat.h"
+#include "GameStateCompression.h"
+#include <nlohmann/json.hpp>
+
+std::optional<GameStateFormat> GameStateFormats::FromName(std::string_view name)
+{
+    if (GameStateCompression::EqualsIgnoreCase(name, "json"))
+        return GameStateFormat::Json;
+    if (GameStateCompression::EqualsIgnoreCase(name, "msgpack"))
+        return GameStateFormat::MsgPack;
+    if (GameStateCompression::EqualsIgnoreCase(name, "cbor"))
+        return GameStateFormat::Cbor;
+    return std::nullopt;
+}
+
+std::string_view GameStateFormats::GetName(GameStateFormat format)
+{
+    switch (format)
+    {
+        case GameStateFormat::MsgPack:
+            return "msgpack";
+        case GameStateFormat::Cbor:
+            return "cbor";
+        default:
+            return "json";
+    }
+}
+
+std::string GameStateFormats::GetContentType(GameStateFormat format)
+{
+    switch (format)
+    {
+        case GameStateFormat::MsgPack:
+            return "application/msgpack";
+        case GameStateFormat::Cbor:
+            return "application/cbor";
+        default:
+            return "application/json";
+    }
+}
+
+GameStateFormat GameStateFormats::Negotiate(std::string const& accept)
+{
+    GameStateFormat best = GameStateFormat::Json;
+    int32 bestQuality = 0;
+
+    // Highest q-value wins, the first listed type wins ties
+    GameStateCompression::ParseHeaderList(accept, [&](std::string_view type, int32 quality)
+    {
+        std::optional<GameStateFormat> format;
+        if (GameStateCompression::EqualsIgnoreCase(type, "application/json") || type == "application/*" || type == "*/*")
+            format = GameStateFormat::Json;
+        else if (GameStateCompression::EqualsIgnoreCase(type, "application/msgpack") || GameStateCompression::EqualsIgnoreCase(type, "application/x-msgpack") ||
+            GameStateCompression::EqualsIgnoreCase(type, "application/vnd.msgpack"))
+            format = GameStateFormat::MsgPack;
+        else if (GameStateCompression::EqualsIgnoreCase(type, "application/cbor"))
+            format = GameStateFormat::Cbor;
+
+        if (format && quality > bestQuality)
+        {
+            best = *format;
+            bestQuality = quality;
+        }
+    });
+
+    return best;
+}
+
+void GameStateFormats::Transcode(std::string& body, GameStateFormat format)
+{
+    if (format == GameStateFormat::Json)
+        return;
+
+    nlohmann::json document = nlohmann::json::parse(body);
+
+    std::string binary;
+    if (format == GameStateFormat::MsgPack)
+        nlohmann::json::to_msgpack(document, binary);
+    else
+        nlohmann::json::to_cbor(document, binary);
+
+    body.swap(binary);
+}
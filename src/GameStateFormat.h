@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_GAMESTATEFORMAT_H
+#define GAMESTATEAPI_GAMESTATEFORMAT_H
+
+#include "Define.h"
+#include <optional>
+#include <string>
+#include <string_view>
+
+enum class GameStateFormat : uint8
+{
+    Json,
+    MsgPack,
+    Cbor
+};
+
+namespace GameStateFormats
+{
+    // "json", "msgpack" or "cbor" as used by ?format=
+    std::optional<GameStateFormat> FromName(std::string_view name);
+    std::string_view GetName(GameStateFormat format);
+    std::string GetContentType(GameStateFormat format);
+
+    // Picks the preferred supported media type from an Accept header,
+    // JSON when nothing else is asked for
+    GameStateFormat Negotiate(std::string const& accept);
+
+    // Converts a JSON body in place to format. Documents are always rendered
+    // as JSON first, binary formats are transcoded from it.
+    void Transcode(std::string& body, GameStateFormat format);
+}
+
+#endif // GAMESTATEAPI_GAMESTATEFORMAT_H
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_GAMESTATEFRAGMENTCACHE_H
+#define GAMESTATEAPI_GAMESTATEFRAGMENTCACHE_H
+
+#include "Define.h"
+#include "GameStateJsonWriter.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Table of pre-serialized JSON for immutable templates (items, quests, spells)
+// indexed by template id. Slots are filled lazily by whichever HTTP thread
+// needs them first and published with a compare-exchange, so lookups never
+// lock. Ids past the end of the table are not cached and callers fall back to
+// serializing the template directly.
+template<typename Fragment>
+class GameStateFragmentCache
+{
+public:
+    GameStateFragmentCache() : _size(0) { }
+    ~GameStateFragmentCache() { Clear(); }
+
+    GameStateFragmentCache(GameStateFragmentCache const&) = delete;
+    GameStateFragmentCache& operator=(GameStateFragmentCache const&) = delete;
+
+    // Not thread safe, only call while no HTTP thread can be reading
+    void Resize(uint32 size)
+    {
+        Clear();
+        _slots = std::make_unique<std::atomic<Fragment const*>[]>(size);
+        for (uint32 i = 0; i < size; ++i)
+            _slots[i].store(nullptr, std::memory_order_relaxed);
+        _size = size;
+    }
+
+    void Clear()
+    {
+        for (uint32 i = 0; i < _size; ++i)
+            delete _slots[i].load(std::memory_order_relaxed);
+        _slots.reset();
+        _size = 0;
+    }
+
+    // Returns the fragment for id, calling build(id) on first use. build
+    // returns a std::unique_ptr<Fragment>; an empty result is not cached.
+    template<typename Builder>
+    Fragment const* Get(uint32 id, Builder&& build)
+    {
+        if (id >= _size)
+            return nullptr;
+
+        std::atomic<Fragment const*>& slot = _slots[id];
+        if (Fragment const* fragment = slot.load(std::memory_order_acquire))
+            return fragment;
+
+        std::unique_ptr<Fragment> built = build(id);
+        if (!built)
+            return nullptr;
+
+        // Another thread may have built the same fragment meanwhile, keep theirs
+        Fragment const* expected = nullptr;
+        if (!slot.compare_exchange_strong(expected, built.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+            return expected;
+
+        return built.release();
+    }
+
+private:
+    std::unique_ptr<std::atomic<Fragment const*>[]> _slots;
+    uint32 _size;
+};
+
+// Compact "key":value members of one template, split into segments around the
+// fields that are only known per request. Each segment is written by its own
+// writer so none of them starts with a separator; GameStateJsonWriter::Raw()
+// adds it when the segment is spliced into a response.
+template<std::size_t Count>
+struct GameStateJsonSegments
+{
+    std::string Json;
+    std::array<std::size_t, Count> Ends = { };
+
+    std::string_view Get(std::size_t index) const
+    {
+        std::size_t begin = index ? Ends[index - 1] : 0;
+        return std::string_view(Json).substr(begin, Ends[index] - begin);
+    }
+
+    // Each writer is a callable taking a GameStateJsonWriter&
+    template<typename... Writers>
+    static std::unique_ptr<GameStateJsonSegments> Build(Writers&&... writers)
+    {
+        static_assert(sizeof...(Writers) == Count, "One writer per segment");
+
+        std::unique_ptr<GameStateJsonSegments> segments = std::make_unique<GameStateJsonSegments>();
+        std::size_t index = 0;
+        ([&]
+        {
+            GameStateJsonWriter writer(segments->Json);
+            writers(writer);
+            segments->Ends[index++] = segments->Json.size();
+        }(), ...);
+
+        segments->Json.shrink_to_fit();
+        return segments;
+    }
+};
+
+#endif // GAMESTATEAPI_GAMESTATEFRAGMENTCACHE_H
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "GameStateJsonWriter.h"
+#include <nlohmann/json.hpp>
+#include <array>
+#include <charconv>
+#include <cmath>
+
+void GameStateJsonWriter::BeginObject()
+{
+    Separate();
+    _buffer.push_back('{');
+    ++_depth;
+    _needComma = false;
+}
+
+void GameStateJsonWriter::EndObject()
+{
+    --_depth;
+
+    // Empty containers stay on one line, like nlohmann's "{}" and "[]"
+    if (_needComma)
+        NewLine();
+
+    _buffer.push_back('}');
+    _needComma = true;
+}
+
+void GameStateJsonWriter::BeginArray()
+{
+    Separate();
+    _buffer.push_back('[');
+    ++_depth;
+    _needComma = false;
+}
+
+void GameStateJsonWriter::EndArray()
+{
+    --_depth;
+
+    if (_needComma)
+        NewLine();
+
+    _buffer.push_back(']');
+    _needComma = true;
+}
+
+void GameStateJsonWriter::Key(std::string_view key)
+{
+    Separate();
+    WriteEscaped(key);
+    _buffer.append(_indent >= 0 ? ": " : ":");
+    _needComma = false;
+    _afterKey = true;
+}
+
+void GameStateJsonWriter::Null()
+{
+    Separate();
+    _buffer.append("null");
+    _needComma = true;
+}
+
+void GameStateJsonWriter::Bool(bool value)
+{
+    Separate();
+    _buffer.append(value ? "true" : "false");
+    _needComma = true;
+}
+
+void GameStateJsonWriter::Int(int64 value)
+{
+    Separate();
+    std::array<char, 24> digits;
+    char* end = std::to_chars(digits.data(), digits.data() + digits.size(), value).ptr;
+    _buffer.append(digits.data(), end);
+    _needComma = true;
+}
+
+void GameStateJsonWriter::UInt(uint64 value)
+{
+    Separate();
+    std::array<char, 24> digits;
+    char* end = std::to_chars(digits.data(), digits.data() + digits.size(), value).ptr;
+    _buffer.append(digits.data(), end);
+    _needComma = true;
+}
+
+void GameStateJsonWriter::Double(double value)
+{
+    Separate();
+    _needComma = true;
+
+    // Same special case and Grisu2 formatting as nlohmann::json's serializer
+    if (!std::isfinite(value))
+    {
+        _buffer.append("null");
+        return;
+    }
+
+    std::array<char, 64> digits;
+    char* end = nlohmann::detail::to_chars(digits.data(), digits.data() + digits.size(), value);
+    _buffer.append(digits.data(), end);
+}
+
+void GameStateJsonWriter::String(std::string_view value)
+{
+    Separate();
+    WriteEscaped(value);
+    _needComma = true;
+}
+
+void GameStateJsonWriter::Raw(std::string_view json)
+{
+    Separate();
+    _buffer.append(json);
+    _needComma = true;
+}
+
+void GameStateJsonWriter::Separate()
+{
+    // A value that follows its key goes on the same line
+    if (_afterKey)
+    {
+        _afterKey = false;
+        return;
+    }
+
+    if (_needComma)
+        _buffer.push_back(',');
+
+    if (_depth > 0)
+        NewLine();
+}
+
+void GameStateJsonWriter::NewLine()
+{
+    if (_indent < 0)
+        return;
+
+    _buffer.push_back('\n');
+    _buffer.append(static_cast<std::size_t>(_depth) * _indent, ' ');
+}
+
+void GameStateJsonWriter::WriteEscaped(std::string_view value)
+{
+    static constexpr char hexDigits[] = "0123456789abcdef";
+
+    _buffer.push_back('"');
+
+    // UTF-8 passes through untouched, like dump() without ensure_ascii
+    std::size_t runStart = 0;
+    for (std::size_t i = 0; i < value.size(); ++i)
+    {
+        unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+
+        _buffer.append(value.data() + runStart, i - runStart);
+        runStart = i + 1;
+
+        switch (c)
+        {
+            case '"':  _buffer.append("\\\""); break;
+            case '\\': _buffer.append("\\\\"); break;
+            case '\b': _buffer.append("\\b"); break;
+            case '\t': _buffer.append("\\t"); break;
+            case '\n': _buffer.append("\\n"); break;
+            case '\f': _buffer.append("\\f"); break;
+            case '\r': _buffer.append("\\r"); break;
+            default:
+                _buffer.append("\\u00");
+                _buffer.push_back(hexDigits[c >> 4]);
+                _buffer.push_back(hexDigits[c & 0xF]);
+                break;
+        }
+    }
+
+    _buffer.append(value.data() + runStart, value.size() - runStart);
+    _buffer.push_back('"');
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_GAMESTATEJSONWRITER_H
+#define GAMESTATEAPI_GAMESTATEJSONWRITER_H
+
+#include "Define.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// SAX-style JSON writer that appends straight into a caller owned buffer.
+// Output is byte-identical to nlohmann::json::dump(indent) for the same
+// document as long as the caller emits object keys in sorted order, which is
+// how nlohmann::json stores them. A negative indent gives the compact form.
+class GameStateJsonWriter
+{
+public:
+    explicit GameStateJsonWriter(std::string& buffer, int indent = -1)
+        : _buffer(buffer), _indent(indent), _depth(0), _needComma(false), _afterKey(false) { }
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+    void Key(std::string_view key);
+
+    void Null();
+    void Bool(bool value);
+    void Int(int64 value);
+    void UInt(uint64 value);
+    void Double(double value);
+    void String(std::string_view value);
+
+    // Appends pre-serialized compact JSON produced by another writer: either a
+    // complete value, or one or more complete "key":value members of the
+    // object currently being written. Only meaningful while IsCompact().
+    void Raw(std::string_view json);
+
+    bool IsCompact() const { return _indent < 0; }
+
+    template<typename T>
+    void Value(T const& value)
+    {
+        if constexpr (std::is_same_v<T, bool>)
+            Bool(value);
+        else if constexpr (std::is_same_v<T, std::nullptr_t>)
+            Null();
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+            Int(value);
+        else if constexpr (std::is_integral_v<T>)
+            UInt(value);
+        else if constexpr (std::is_floating_point_v<T>)
+            Double(value);
+        else if constexpr (std::is_enum_v<T>)
+            Value(static_cast<std::underlying_type_t<T>>(value));
+        else
+            String(value);
+    }
+
+    template<typename T>
+    void Field(std::string_view key, T const& value)
+    {
+        Key(key);
+        Value(value);
+    }
+
+    std::string& GetBuffer() { return _buffer; }
+
+private:
+    void Separate();
+    void NewLine();
+    void WriteEscaped(std::string_view value);
+
+    std::string& _buffer;
+    int _indent;
+    int _depth;
+    bool _needComma;
+    bool _afterKey;
+};
+
+#endif // GAMESTATEAPI_GAMESTATEJSONWRITER_H
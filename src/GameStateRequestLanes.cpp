@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "GameStateRequestLanes.h"
+
+GameStateRequestLanes::Slot& GameStateRequestLanes::Slot::operator=(Slot&& other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        _lanes = other._lanes;
+        _cost = other._cost;
+        other._lanes = nullptr;
+    }
+    return *this;
+}
+
+void GameStateRequestLanes::Slot::Release()
+{
+    if (!_lanes)
+        return;
+
+    if (_cost != GameStateCostClass::Light)
+    {
+        _lanes->_inUse[std::size_t(_cost)].fetch_sub(1, std::memory_order_relaxed);
+        _lanes->_busy.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    _lanes = nullptr;
+}
+
+GameStateRequestLanes::GameStateRequestLanes(std::array<uint32, std::size_t(GameStateCostClass::Max)> const& limits, uint32 busyLimit)
+    : _limits(limits), _busyLimit(busyLimit), _busy(0)
+{
+    for (std::atomic<uint32>& inUse : _inUse)
+        inUse.store(0, std::memory_order_relaxed);
+}
+
+GameStateRequestLanes::Slot GameStateRequestLanes::TryAcquire(GameStateCostClass cost)
+{
+    if (cost == GameStateCostClass::Light)
+        return Slot(this, cost);
+
+    // Optimistically take the slot and give it back if that went over a limit
+    if (_busy.fetch_add(1, std::memory_order_relaxed) >= _busyLimit)
+    {
+        _busy.fetch_sub(1, std::memory_order_relaxed);
+        return Slot();
+    }
+
+    uint32 limit = _limits[std::size_t(cost)];
+    if (_inUse[std::size_t(cost)].fetch_add(1, std::memory_order_relaxed) >= limit && limit)
+    {
+        _inUse[std::size_t(cost)].fetch_sub(1, std::memory_order_relaxed);
+        _busy.fetch_sub(1, std::memory_order_relaxed);
+        return Slot();
+    }
+
+    return Slot(this, cost);
+}
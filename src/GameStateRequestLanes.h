@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_GAMESTATEREQUESTLANES_H
+#define GAMESTATEAPI_GAMESTATEREQUESTLANES_H
+
+#include "Define.h"
+#include <array>
+#include <atomic>
+
+// How expensive an endpoint is to serve, each class has its own lane
+enum class GameStateCostClass : uint8
+{
+    Light,      // health and server info, never limited
+    Player,     // one player
+    Collection, // player lists, maps and batches
+    Stream,     // server-sent event streams, which hold a worker while open
+    Max
+};
+
+// Admission control over the HTTP workers. Each lane but Light may only keep
+// so many workers busy at once, and all of them together leave some workers
+// free, so cheap requests find a worker however busy the heavy lanes are.
+// A request over its lane's limit is turned away at once rather than
+// waiting, since waiting would hold a worker too.
+class GameStateRequestLanes
+{
+public:
+    // A worker held by a lane, released when destroyed
+    class Slot
+    {
+    public:
+        Slot() = default;
+        Slot(Slot&& other) noexcept : _lanes(other._lanes), _cost(other._cost) { other._lanes = nullptr; }
+        Slot& operator=(Slot&& other) noexcept;
+        ~Slot() { Release(); }
+
+        Slot(Slot const&) = delete;
+        Slot& operator=(Slot const&) = delete;
+
+        explicit operator bool() const { return _lanes != nullptr; }
+
+    private:
+        friend class GameStateRequestLanes;
+
+        Slot(GameStateRequestLanes* lanes, GameStateCostClass cost) : _lanes(lanes), _cost(cost) { }
+        void Release();
+
+        GameStateRequestLanes* _lanes = nullptr;
+        GameStateCostClass _cost = GameStateCostClass::Light;
+    };
+
+    // limits holds the most workers each class may use (0 for no limit of
+    // its own); busyLimit caps all classes but Light together
+    GameStateRequestLanes(std::array<uint32, std::size_t(GameStateCostClass::Max)> const& limits, uint32 busyLimit);
+
+    // An empty slot when the lane is full
+    Slot TryAcquire(GameStateCostClass cost);
+
+private:
+    std::array<uint32, std::size_t(GameStateCostClass::Max)> _limits;
+    uint32 _busyLimit;
+
+    std::array<std::atomic<uint32>, std::size_t(GameStateCostClass::Max)> _inUse;
+    std::atomic<uint32> _busy;
+};
+
+#endif // GAMESTATEAPI_GAMESTATEREQUESTLANES_H
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_GAMESTATERESPONSECACHE_H
+#define GAMESTATEAPI_GAMESTATERESPONSECACHE_H
+
+#include "GameStateCompression.h"
+#include "GameStateFormat.h"
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+// Fully rendered (and possibly compressed) response, shared read-only by
+// every request for the same document
+struct GameStateCachedResponse
+{
+    int Status = 200;
+    std::string Body;
+    GameStateFormat Format = GameStateFormat::Json;
+    GameStateEncoding Encoding = GameStateEncoding::Identity;
+};
+
+using GameStateCachedResponsePtr = std::shared_ptr<GameStateCachedResponse const>;
+
+// Single-flight table of rendered responses keyed by endpoint, query and
+// encoding. The first request for a key renders it; identical requests that
+// arrive meanwhile wait for that result instead of doing the same work.
+//
+// Each snapshot owns one that keeps its entries, so they go away together
+// with the snapshot once the last request still reading it has finished.
+// Live queries use one that drops each entry as soon as it is rendered.
+class GameStateResponseCache
+{
+public:
+    // render() returns a GameStateCachedResponsePtr. If it throws, every
+    // waiting request sees the exception and the key is rendered anew next time.
+    template<typename Render>
+    GameStateCachedResponsePtr GetOrRender(std::string const& key, Render&& render, bool keep = true)
+    {
+        std::shared_future<GameStateCachedResponsePtr> pending = Find(key);
+        if (pending.valid())
+            return pending.get();
+
+        std::promise<GameStateCachedResponsePtr> promise;
+        {
+            std::unique_lock lock(_lock);
+            auto [itr, inserted] = _responses.try_emplace(key, promise.get_future().share());
+            if (!inserted)
+                pending = itr->second;
+        }
+
+        // Lost the race to another request for the same key
+        if (pending.valid())
+            return pending.get();
+
+        GameStateCachedResponsePtr response;
+        try
+        {
+            response = render();
+            promise.set_value(response);
+        }
+        catch (...)
+        {
+            promise.set_exception(std::current_exception());
+            Erase(key);
+            throw;
+        }
+
+        if (!keep)
+            Erase(key);
+
+        return response;
+    }
+
+private:
+    std::shared_future<GameStateCachedResponsePtr> Find(std::string const& key) const
+    {
+        std::shared_lock lock(_lock);
+        auto itr = _responses.find(key);
+        return itr != _responses.end() ? itr->second : std::shared_future<GameStateCachedResponsePtr>();
+    }
+
+    void Erase(std::string const& key)
+    {
+        std::unique_lock lock(_lock);
+        _responses.erase(key);
+    }
+
+    mutable std::shared_mutex _lock;
+    std::unordered_map<std::string, std::shared_future<GameStateCachedResponsePtr>> _responses;
+};
+
+#endif // GAMESTATEAPI_GAMESTATERESPONSECACHE_H
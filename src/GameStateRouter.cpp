@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "GameStateRouter.h"
+#include <algorithm>
+#include <stdexcept>
+
+GameStateRouter::GameStateRouter() = default;
+GameStateRouter::~GameStateRouter() = default;
+
+void GameStateRouter::Add(std::string_view pattern, Handler handler)
+{
+    if (pattern.empty() || pattern.front() != '/')
+        throw std::invalid_argument("Route pattern must start with '/': " + std::string(pattern));
+
+    Node* node = &_root;
+    std::size_t captures = 0;
+    std::string_view rest = pattern.substr(1);
+    while (true)
+    {
+        std::size_t end = std::min(rest.find('/'), rest.size());
+        std::string_view segment = rest.substr(0, end);
+
+        if (segment.size() >= 2 && segment.front() == '{' && segment.back() == '}')
+        {
+            std::string_view capture = segment.substr(1, segment.size() - 2);
+            std::size_t colon = capture.find(':');
+            CaptureType type = CaptureType::Any;
+            if (colon != std::string_view::npos)
+            {
+                if (capture.substr(colon + 1) != "uint")
+                    throw std::invalid_argument("Unknown capture type in route: " + std::string(pattern));
+                type = CaptureType::Unsigned;
+            }
+
+            if (++captures > GameStateRouteParams::MAX_PARAMS)
+                throw std::invalid_argument("Too many captures in route: " + std::string(pattern));
+
+            // Routes sharing a prefix must agree on the type of a capture there
+            if (!node->Capture)
+            {
+                node->Capture = std::make_unique<Node>();
+                node->Capture->Type = type;
+            }
+            else if (node->Capture->Type != type)
+                throw std::invalid_argument("Conflicting capture type in route: " + std::string(pattern));
+
+            node = node->Capture.get();
+        }
+        else
+        {
+            auto itr = std::find_if(node->Literals.begin(), node->Literals.end(),
+                [segment](std::pair<std::string, std::unique_ptr<Node>> const& literal) { return literal.first == segment; });
+            if (itr == node->Literals.end())
+                itr = node->Literals.insert(node->Literals.end(), { std::string(segment), std::make_unique<Node>() });
+
+            node = itr->second.get();
+        }
+
+        if (end == rest.size())
+            break;
+
+        rest.remove_prefix(end + 1);
+    }
+
+    if (node->Target)
+        throw std::invalid_argument("Route added twice: " + std::string(pattern));
+
+    node->Target = std::move(handler);
+}
+
+GameStateRouter::Handler const* GameStateRouter::Match(std::string_view path, GameStateRouteParams& params) const
+{
+    params._count = 0;
+    if (path.empty() || path.front() != '/')
+        return nullptr;
+
+    return Match(_root, path.substr(1), params);
+}
+
+GameStateRouter::Handler const* GameStateRouter::Match(Node const& node, std::string_view path, GameStateRouteParams& params)
+{
+    std::size_t end = std::min(path.find('/'), path.size());
+    std::string_view segment = path.substr(0, end);
+    bool last = end == path.size();
+    std::string_view rest = last ? std::string_view() : path.substr(end + 1);
+
+    for (auto const& [literal, child] : node.Literals)
+    {
+        if (literal != segment)
+            continue;
+
+        if (last)
+        {
+            if (child->Target)
+                return &child->Target;
+        }
+        else if (Handler const* handler = Match(*child, rest, params))
+            return handler;
+
+        break;
+    }
+
+    Node const* capture = node.Capture.get();
+    if (!capture || segment.empty())
+        return nullptr;
+
+    if (capture->Type == CaptureType::Unsigned &&
+        !std::all_of(segment.begin(), segment.end(), [](char c) { return c >= '0' && c <= '9'; }))
+        return nullptr;
+
+    std::size_t count = params._count;
+    params._values[params._count++] = segment;
+
+    if (last)
+    {
+        if (capture->Target)
+            return &capture->Target;
+    }
+    else if (Handler const* handler = Match(*capture, rest, params))
+        return handler;
+
+    // Backtrack, a literal sibling further up may still match
+    params._count = count;
+    return nullptr;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_GAMESTATEROUTER_H
+#define GAMESTATEAPI_GAMESTATEROUTER_H
+
+#include "Define.h"
+#include <yhirose/httplib.h>
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Values of a route's {name} segments in path order, viewing into the request path
+class GameStateRouteParams
+{
+public:
+    static constexpr std::size_t MAX_PARAMS = 4;
+
+    std::string_view operator[](std::size_t index) const { return _values[index]; }
+    std::size_t size() const { return _count; }
+
+private:
+    friend class GameStateRouter;
+
+    std::array<std::string_view, MAX_PARAMS> _values;
+    std::size_t _count = 0;
+};
+
+// Segment trie of GET routes. Patterns are split on '/' into literal segments,
+// {name} (any non-empty segment) and {name:uint} (digits only). A request is
+// matched segment by segment, literals before captures, so dispatch costs
+// O(path length) without regexes or allocations.
+class GameStateRouter
+{
+public:
+    using Handler = std::function<void(const httplib::Request&, httplib::Response&, GameStateRouteParams const&)>;
+
+    GameStateRouter();
+    ~GameStateRouter();
+
+    // Throws std::invalid_argument for a malformed pattern or one already added
+    void Add(std::string_view pattern, Handler handler);
+
+    // Handler of the route path matches, with its captures stored in params;
+    // nullptr when no route does
+    Handler const* Match(std::string_view path, GameStateRouteParams& params) const;
+
+private:
+    enum class CaptureType : uint8
+    {
+        Any,
+        Unsigned
+    };
+
+    struct Node
+    {
+        std::vector<std::pair<std::string, std::unique_ptr<Node>>> Literals;
+        std::unique_ptr<Node> Capture;
+        CaptureType Type = CaptureType::Any;
+        Handler Target;
+    };
+
+    static Handler const* Match(Node const& node, std::string_view path, GameStateRouteParams& params);
+
+    Node _root;
+};
+
+#endif // GAMESTATEAPI_GAMESTATEROUTER_H
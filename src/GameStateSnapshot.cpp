@@ -0,0 +1,682 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "GameStateSnapshot.h"
+#include "GameStateUtilities.h"
+#include "GameTime.h"
+#include "Group.h"
+#include "Guild.h"
+#include "GuildMgr.h"
+#include "Item.h"
+#include "Log.h"
+#include "ObjectAccessor.h"
+#include "Player.h"
+#include "WorldSession.h"
+#include "WorldSessionMgr.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+
+static_assert(GAME_STATE_EQUIPMENT_SLOTS == EQUIPMENT_SLOT_END, "Equipment snapshot size does not match EQUIPMENT_SLOT_END");
+
+GameStateStringPool::GameStateStringPool() : _size(0)
+{
+    for (std::atomic<std::string*>& chunk : _chunks)
+        chunk.store(nullptr, std::memory_order_relaxed);
+
+    // Id 0 is the empty string, so default constructed snapshots resolve
+    Intern("");
+}
+
+GameStateStringPool::~GameStateStringPool()
+{
+    for (std::atomic<std::string*>& chunk : _chunks)
+        delete[] chunk.load(std::memory_order_relaxed);
+}
+
+uint32 GameStateStringPool::Intern(std::string const& value)
+{
+    auto itr = _ids.find(value);
+    if (itr != _ids.end())
+        return itr->second;
+
+    uint32 chunkIndex = _size >> CHUNK_SHIFT;
+    if (chunkIndex >= MAX_CHUNKS)
+    {
+        LOG_ERROR("module.gamestate_api", "Game state string pool is full, \"{}\" is left out", value);
+        return 0;
+    }
+
+    std::string* chunk = _chunks[chunkIndex].load(std::memory_order_relaxed);
+    if (!chunk)
+    {
+        chunk = new std::string[CHUNK_SIZE];
+        _chunks[chunkIndex].store(chunk, std::memory_order_release);
+    }
+
+    uint32 id = _size++;
+    chunk[id & (CHUNK_SIZE - 1)] = value;
+    _ids.emplace(value, id);
+    return id;
+}
+
+std::string const& GameStateStringPool::Get(uint32 id) const
+{
+    // Readers got the id from a snapshot published after the string was stored
+    return _chunks[id >> CHUNK_SHIFT].load(std::memory_order_acquire)[id & (CHUNK_SIZE - 1)];
+}
+
+PlayerSnapshot const* GameStateSnapshot::FindPlayer(std::string_view name) const
+{
+    if (!Names)
+        return nullptr;
+
+    // A player that logged in after this snapshot was taken is not in Players yet
+    auto itr = Names->find(NormalizeName(name));
+    return itr != Names->end() ? FindPlayerByGuid(itr->second) : nullptr;
+}
+
+PlayerSnapshot const* GameStateSnapshot::FindPlayerByGuid(ObjectGuid::LowType guid) const
+{
+    auto itr = std::lower_bound(Players.begin(), Players.end(), guid,
+        [](PlayerSnapshot const& player, ObjectGuid::LowType counter) { return player.Guid.GetCounter() < counter; });
+    return itr != Players.end() && itr->Guid.GetCounter() == guid ? &*itr : nullptr;
+}
+
+bool GameStateSnapshot::HasPlayer(ObjectGuid guid) const
+{
+    PlayerSnapshot const* player = FindPlayerByGuid(guid.GetCounter());
+    return player && player->Guid == guid;
+}
+
+PlayerIndexList const* GameStateSnapshot::FindPlayers(PlayerIndexType index, uint32 key) const
+{
+    auto itr = PlayerIndexes[index].find(key);
+    return itr != PlayerIndexes[index].end() ? itr->second.get() : nullptr;
+}
+
+PlayerPositionGrid const* GameStateSnapshot::FindPositionGrid(uint32 mapId) const
+{
+    auto itr = PositionGrids.find(mapId);
+    return itr != PositionGrids.end() ? itr->second.get() : nullptr;
+}
+
+int32 PlayerPositionGrid::GetCell(float coordinate)
+{
+    float cell = std::floor(coordinate / GAME_STATE_GRID_CELL_SIZE);
+    // Keeps absurd query boxes from overflowing; no map is anywhere near this large
+    return static_cast<int32>(std::clamp(cell, -1000000.0f, 1000000.0f));
+}
+
+uint64 PlayerPositionGrid::GetCellKey(int32 cellX, int32 cellY)
+{
+    return (uint64(uint32(cellX)) << 32) | uint32(cellY);
+}
+
+std::string GameStateSnapshot::NormalizeName(std::string_view name)
+{
+    std::string normalized(name);
+    std::transform(normalized.begin(), normalized.end(), normalized.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return normalized;
+}
+
+GameStateSnapshotMgr::GameStateSnapshotMgr() : _strings(std::make_shared<GameStateStringPool>()), _namesSeeded(false), _updateInterval(100), _updateTimer(0), _version(0), _firstVersion(0)
+{
+    for (std::atomic<int64>& time : _fieldRequestTimes)
+        time.store(std::numeric_limits<int64>::min(), std::memory_order_relaxed);
+}
+
+GameStateSnapshotMgr::~GameStateSnapshotMgr()
+{
+    Reset();
+}
+
+GameStateSnapshotMgr* GameStateSnapshotMgr::instance()
+{
+    static GameStateSnapshotMgr instance;
+    return &instance;
+}
+
+void GameStateSnapshotMgr::Update(uint32 diff)
+{
+    // Queries are answered every tick so that detail endpoints never wait
+    // longer than one world update, independently of the snapshot interval.
+    ProcessQueries();
+
+    _updateTimer += Milliseconds(diff);
+    if (_updateTimer < _updateInterval)
+        return;
+
+    _updateTimer = Milliseconds::zero();
+    BuildSnapshot();
+}
+
+void GameStateSnapshotMgr::Reset()
+{
+    Publish(nullptr);
+    _previous.reset();
+    _removedPlayers.reset();
+    _names.clear();
+    _publishedNames.reset();
+    _namesSeeded = false;
+
+    // Nobody will answer queries anymore, release any waiting HTTP thread
+    PlayerQuery* query = nullptr;
+    while (_queries.Dequeue(query))
+    {
+        query->Handler(nullptr);
+        delete query;
+    }
+}
+
+void GameStateSnapshotMgr::AddPlayerName(Player* player)
+{
+    _names[GameStateSnapshot::NormalizeName(player->GetName())] = player->GetGUID().GetCounter();
+    _publishedNames.reset();
+}
+
+void GameStateSnapshotMgr::RemovePlayerName(Player* player)
+{
+    // Only if the name still belongs to this character
+    auto itr = _names.find(GameStateSnapshot::NormalizeName(player->GetName()));
+    if (itr != _names.end() && itr->second == player->GetGUID().GetCounter())
+    {
+        _names.erase(itr);
+        _publishedNames.reset();
+    }
+}
+
+GameStateSnapshotPtr GameStateSnapshotMgr::GetSnapshot() const
+{
+#ifdef __cpp_lib_atomic_shared_ptr
+    return _snapshot.load(std::memory_order_acquire);
+#else
+    return std::atomic_load_explicit(&_snapshot, std::memory_order_acquire);
+#endif
+}
+
+GameStateSnapshotPtr GameStateSnapshotMgr::WaitForSnapshot(uint64 version, Milliseconds timeout) const
+{
+    std::unique_lock<std::mutex> lock(_publishLock);
+    _published.wait_for(lock, timeout, [this, version]()
+    {
+        GameStateSnapshotPtr snapshot = GetSnapshot();
+        return !snapshot || snapshot->Version > version;
+    });
+
+    return GetSnapshot();
+}
+
+static int64 GetSteadyTimeMS()
+{
+    return std::chrono::duration_cast<Milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void GameStateSnapshotMgr::RequestPlayerFields(uint32 fields)
+{
+    int64 now = GetSteadyTimeMS();
+    for (uint32 bit = 0; bit < _fieldRequestTimes.size(); ++bit)
+    {
+        if (fields & PLAYER_FIELDS_ON_DEMAND & (1u << bit))
+            _fieldRequestTimes[bit].store(now, std::memory_order_relaxed);
+    }
+}
+
+uint32 GameStateSnapshotMgr::GetRequestedFields() const
+{
+    int64 now = GetSteadyTimeMS();
+    int64 timeout = std::chrono::duration_cast<Milliseconds>(GAME_STATE_FIELD_DEMAND_TIMEOUT).count();
+
+    uint32 fields = PLAYER_FIELDS_ALL & ~PLAYER_FIELDS_ON_DEMAND;
+    for (uint32 bit = 0; bit < _fieldRequestTimes.size(); ++bit)
+    {
+        int64 requested = _fieldRequestTimes[bit].load(std::memory_order_relaxed);
+        if ((PLAYER_FIELDS_ON_DEMAND & (1u << bit)) && requested > now - timeout)
+            fields |= 1u << bit;
+    }
+
+    return fields;
+}
+
+GameStateSnapshotPtr GameStateSnapshotMgr::GetSnapshot(uint32 fields, Milliseconds timeout)
+{
+    RequestPlayerFields(fields);
+
+    // A section nobody asked for lately is captured from the next snapshot on
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+    GameStateSnapshotPtr snapshot = GetSnapshot();
+    while (snapshot && (snapshot->CapturedFields & fields) != fields)
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+            return nullptr;
+
+        snapshot = WaitForSnapshot(snapshot->Version, std::chrono::duration_cast<Milliseconds>(deadline - now) + Milliseconds(1));
+    }
+
+    return snapshot;
+}
+
+void GameStateSnapshotMgr::Publish(GameStateSnapshotPtr snapshot)
+{
+    {
+        // Store under the lock so a waiter cannot miss the notification
+        std::lock_guard<std::mutex> lock(_publishLock);
+#ifdef __cpp_lib_atomic_shared_ptr
+        _snapshot.store(std::move(snapshot), std::memory_order_release);
+#else
+        std::atomic_store_explicit(&_snapshot, std::move(snapshot), std::memory_order_release);
+#endif
+    }
+
+    _published.notify_all();
+}
+
+void GameStateSnapshotMgr::EnqueueQuery(ObjectGuid guid, std::function<void(Player*)> handler)
+{
+    PlayerQuery* query = new PlayerQuery();
+    query->Guid = guid;
+    query->Handler = std::move(handler);
+    _queries.Enqueue(query);
+}
+
+void GameStateSnapshotMgr::ProcessQueries()
+{
+    PlayerQuery* query = nullptr;
+    while (_queries.Dequeue(query))
+    {
+        Player* player = ObjectAccessor::FindPlayer(query->Guid);
+        query->Handler(player && player->IsInWorld() ? player : nullptr);
+        delete query;
+    }
+}
+
+void GameStateSnapshotMgr::CaptureServer(ServerSnapshot& server) const
+{
+    server.UptimeSeconds = GameTime::GetUptime().count();
+    server.CurrentTime = GameTime::GetGameTime().count();
+    server.StartTime = GameTime::GetStartTime().count();
+    server.PlayerCount = sWorldSessionMgr->GetPlayerCount();
+    server.MaxPlayerCount = sWorldSessionMgr->GetMaxPlayerCount();
+    server.ActiveSessions = sWorldSessionMgr->GetActiveSessionCount();
+    server.QueuedSessions = sWorldSessionMgr->GetQueuedSessionCount();
+    server.TotalSessions = sWorldSessionMgr->GetActiveAndQueuedSessionCount();
+}
+
+void GameStateSnapshotMgr::CapturePlayer(Player* player, PlayerSnapshot& snapshot, uint32 fields)
+{
+    snapshot.Guid = player->GetGUID();
+    snapshot.NameId = _strings->Intern(player->GetName());
+    snapshot.Level = player->GetLevel();
+    snapshot.Class = player->getClass();
+    snapshot.Race = player->getRace();
+    snapshot.Gender = player->getGender();
+    snapshot.ZoneId = player->GetZoneId();
+    snapshot.AreaId = player->GetAreaId();
+    snapshot.MapId = player->GetMapId();
+
+    if (WorldSession* session = player->GetSession())
+    {
+        snapshot.HasSession = true;
+        snapshot.AccountId = session->GetAccountId();
+        snapshot.AccountNameId = _strings->Intern(session->GetPlayerName());
+        snapshot.Latency = session->GetLatency();
+        snapshot.SecurityLevel = static_cast<uint32>(session->GetSecurity());
+    }
+
+    Guild* guild = (fields & PLAYER_FIELD_GUILD) ? sGuildMgr->GetGuildById(player->GetGuildId()) : nullptr;
+    if (guild)
+    {
+        snapshot.HasGuild = true;
+        snapshot.GuildId = player->GetGuildId();
+        snapshot.GuildNameId = _strings->Intern(guild->GetName());
+        snapshot.GuildRank = player->GetRank();
+    }
+
+    snapshot.Money = player->GetMoney();
+    snapshot.TotalPlayedTime = player->GetTotalPlayedTime();
+    snapshot.LevelPlayedTime = player->GetLevelPlayedTime();
+    snapshot.HonorPoints = player->GetHonorPoints();
+    snapshot.ArenaPoints = player->GetArenaPoints();
+
+    snapshot.PositionX = player->GetPositionX();
+    snapshot.PositionY = player->GetPositionY();
+    snapshot.PositionZ = player->GetPositionZ();
+    snapshot.Orientation = player->GetOrientation();
+
+    snapshot.Health = player->GetHealth();
+    snapshot.MaxHealth = player->GetMaxHealth();
+
+    Powers primaryPower = player->getPowerType();
+    snapshot.PowerType = static_cast<uint32>(primaryPower);
+    snapshot.Power = player->GetPower(primaryPower);
+    snapshot.MaxPower = player->GetMaxPower(primaryPower);
+
+    Group* group = (fields & PLAYER_FIELD_GROUP) ? player->GetGroup() : nullptr;
+    if (group)
+    {
+        snapshot.HasGroup = true;
+        snapshot.GroupId = group->GetGUID().GetCounter();
+        snapshot.GroupLeaderGuid = group->GetLeaderGUID().GetCounter();
+        snapshot.GroupMembersCount = group->GetMembersCount();
+        snapshot.IsGroupLeader = group->IsLeader(player->GetGUID());
+        snapshot.IsGroupAssistant = group->IsAssistant(player->GetGUID());
+        snapshot.GroupLootMethod = static_cast<uint32>(group->GetLootMethod());
+        snapshot.IsRaidGroup = group->isRaidGroup();
+        snapshot.IsBGGroup = group->isBGGroup();
+        snapshot.IsLFGGroup = group->isLFGGroup();
+    }
+
+    if (fields & PLAYER_FIELD_STATS)
+    {
+        snapshot.Strength = player->GetStat(STAT_STRENGTH);
+        snapshot.Agility = player->GetStat(STAT_AGILITY);
+        snapshot.Stamina = player->GetStat(STAT_STAMINA);
+        snapshot.Intellect = player->GetStat(STAT_INTELLECT);
+        snapshot.Spirit = player->GetStat(STAT_SPIRIT);
+        snapshot.AverageItemLevel = player->GetAverageItemLevel();
+    }
+
+    snapshot.IsAlive = player->IsAlive();
+    snapshot.IsInCombat = player->IsInCombat();
+    snapshot.IsGhost = player->HasFlag(PLAYER_FLAGS, PLAYER_FLAGS_GHOST);
+    snapshot.IsResting = player->HasPlayerFlag(PLAYER_FLAGS_RESTING);
+    snapshot.IsAway = player->isAFK();
+    snapshot.IsDnd = player->isDND();
+    snapshot.IsGameMaster = player->IsGameMaster();
+
+    if (fields & PLAYER_FIELD_EQUIPMENT)
+    {
+        for (uint8 slot = EQUIPMENT_SLOT_START; slot < EQUIPMENT_SLOT_END; ++slot)
+        {
+            snapshot.Equipment[slot] = GameStateUtilities::GetItemSnapshot(player->GetItemByPos(INVENTORY_SLOT_BAG_0, slot));
+        }
+    }
+}
+
+void GameStateSnapshotMgr::TrackChanges(GameStateSnapshot& snapshot, GameStateStringPool const* previousStrings)
+{
+    GameStateSnapshot const* previous = _previous.get();
+    PlayerRemovalList removed;
+    bool changed = !previous;
+
+    // Ids of the previous pool, in the one this snapshot uses
+    auto translate = [&](uint32 id) { return previousStrings ? _strings->Intern(previousStrings->Get(id)) : id; };
+
+    // Both player lists are sorted by guid, walk them side by side
+    std::size_t previousIndex = 0;
+    auto removePrevious = [&]()
+    {
+        PlayerSnapshot const& old = previous->Players[previousIndex++];
+        removed.push_back({ old.Guid, translate(old.NameId), snapshot.Version });
+    };
+
+    for (PlayerSnapshot& player : snapshot.Players)
+    {
+        while (previous && previousIndex < previous->Players.size() && previous->Players[previousIndex].Guid.GetCounter() < player.Guid.GetCounter())
+            removePrevious();
+
+        if (previous && previousIndex < previous->Players.size() && previous->Players[previousIndex].Guid == player.Guid)
+        {
+            PlayerSnapshot const& old = previous->Players[previousIndex++];
+            player.AddedVersion = old.AddedVersion;
+            player.ChangedVersion = old.ChangedVersion;
+
+            bool same;
+            if (previousStrings)
+            {
+                PlayerSnapshot translated = old;
+                translated.NameId = translate(old.NameId);
+                translated.AccountNameId = translate(old.AccountNameId);
+                translated.GuildNameId = translate(old.GuildNameId);
+                same = player == translated;
+            }
+            else
+                same = player == old;
+
+            if (!same)
+            {
+                player.ChangedVersion = snapshot.Version;
+                changed = true;
+            }
+        }
+        else
+        {
+            player.AddedVersion = snapshot.Version;
+            player.ChangedVersion = snapshot.Version;
+            changed = true;
+        }
+    }
+
+    while (previous && previousIndex < previous->Players.size())
+        removePrevious();
+
+    snapshot.PlayersChangedVersion = (changed || !removed.empty()) ? snapshot.Version : previous->PlayersChangedVersion;
+
+    snapshot.DeltaBaseVersion = std::max(_firstVersion, snapshot.Version > GAME_STATE_DELTA_HISTORY ? snapshot.Version - GAME_STATE_DELTA_HISTORY : 0);
+
+    // The removal list is shared between snapshots and only copied when it changes
+    bool expired = _removedPlayers && !_removedPlayers->empty() && _removedPlayers->front().Version <= snapshot.DeltaBaseVersion;
+    if (!removed.empty() || expired || !_removedPlayers || previousStrings)
+    {
+        // A player removed again only keeps its latest removal
+        std::unordered_set<uint64> removedGuids;
+        for (PlayerRemoval const& removal : removed)
+            removedGuids.insert(removal.Guid.GetRawValue());
+
+        std::shared_ptr<PlayerRemovalList> removedPlayers = std::make_shared<PlayerRemovalList>();
+        if (_removedPlayers)
+        {
+            for (PlayerRemoval const& removal : *_removedPlayers)
+            {
+                if (removal.Version > snapshot.DeltaBaseVersion && !removedGuids.count(removal.Guid.GetRawValue()))
+                    removedPlayers->push_back({ removal.Guid, translate(removal.NameId), removal.Version });
+            }
+        }
+
+        removedPlayers->insert(removedPlayers->end(), removed.begin(), removed.end());
+        _removedPlayers = std::move(removedPlayers);
+    }
+
+    snapshot.RemovedPlayers = _removedPlayers;
+}
+
+// Key of player in index, if it has one
+static std::optional<uint32> GetPlayerIndexKey(PlayerSnapshot const& player, PlayerIndexType index)
+{
+    switch (index)
+    {
+        case PLAYER_INDEX_MAP:
+            return player.MapId;
+        case PLAYER_INDEX_ZONE:
+            return player.ZoneId;
+        case PLAYER_INDEX_GUILD:
+            return player.HasGuild ? std::optional<uint32>(player.GuildId) : std::nullopt;
+        case PLAYER_INDEX_GROUP:
+            return player.HasGroup ? std::optional<uint32>(player.GroupId) : std::nullopt;
+        default:
+            return std::nullopt;
+    }
+}
+
+void GameStateSnapshotMgr::IndexPlayers(GameStateSnapshot& snapshot) const
+{
+    GameStateSnapshot const* previous = _previous.get();
+
+    // A bucket only has to be rebuilt if a player entered or left it, or if
+    // one of its players moved to another position in Players because
+    // someone before it logged in or out. The others are shared as they are.
+    std::array<std::unordered_set<uint32>, MAX_PLAYER_INDEXES> dirty;
+    auto markDirty = [&dirty](PlayerSnapshot const& player)
+    {
+        for (uint8 index = 0; index < MAX_PLAYER_INDEXES; ++index)
+            if (std::optional<uint32> key = GetPlayerIndexKey(player, PlayerIndexType(index)))
+                dirty[index].insert(*key);
+    };
+
+    std::size_t previousIndex = 0;
+    for (std::size_t i = 0; i < snapshot.Players.size(); ++i)
+    {
+        PlayerSnapshot const& player = snapshot.Players[i];
+        while (previous && previousIndex < previous->Players.size() && previous->Players[previousIndex].Guid.GetCounter() < player.Guid.GetCounter())
+            markDirty(previous->Players[previousIndex++]);
+
+        if (previous && previousIndex < previous->Players.size() && previous->Players[previousIndex].Guid == player.Guid)
+        {
+            PlayerSnapshot const& old = previous->Players[previousIndex];
+            for (uint8 index = 0; index < MAX_PLAYER_INDEXES; ++index)
+            {
+                std::optional<uint32> oldKey = GetPlayerIndexKey(old, PlayerIndexType(index));
+                std::optional<uint32> key = GetPlayerIndexKey(player, PlayerIndexType(index));
+                if (oldKey == key && previousIndex == i)
+                    continue;
+
+                if (oldKey)
+                    dirty[index].insert(*oldKey);
+                if (key)
+                    dirty[index].insert(*key);
+            }
+
+            ++previousIndex;
+        }
+        else
+            markDirty(player);
+    }
+
+    while (previous && previousIndex < previous->Players.size())
+        markDirty(previous->Players[previousIndex++]);
+
+    for (uint8 index = 0; index < MAX_PLAYER_INDEXES; ++index)
+    {
+        PlayerIndexMap& buckets = snapshot.PlayerIndexes[index];
+        if (previous)
+        {
+            buckets = previous->PlayerIndexes[index];
+            for (uint32 key : dirty[index])
+                buckets.erase(key);
+        }
+
+        if (previous && dirty[index].empty())
+            continue;
+
+        std::unordered_map<uint32, std::shared_ptr<PlayerIndexList>> rebuilt;
+        for (std::size_t i = 0; i < snapshot.Players.size(); ++i)
+        {
+            std::optional<uint32> key = GetPlayerIndexKey(snapshot.Players[i], PlayerIndexType(index));
+            if (!key || (previous && !dirty[index].count(*key)))
+                continue;
+
+            std::shared_ptr<PlayerIndexList>& bucket = rebuilt[*key];
+            if (!bucket)
+                bucket = std::make_shared<PlayerIndexList>();
+            bucket->push_back(static_cast<uint32>(i));
+        }
+
+        for (auto& [key, bucket] : rebuilt)
+            buckets[key] = std::move(bucket);
+    }
+
+    // A map keeps its previous grid while the same players (at the same
+    // Players indexes) are on it and none of them moved
+    for (auto const& [mapId, bucket] : snapshot.PlayerIndexes[PLAYER_INDEX_MAP])
+    {
+        if (previous)
+        {
+            auto previousBucket = previous->PlayerIndexes[PLAYER_INDEX_MAP].find(mapId);
+            auto previousGrid = previous->PositionGrids.find(mapId);
+            if (previousBucket != previous->PlayerIndexes[PLAYER_INDEX_MAP].end() && previousBucket->second == bucket &&
+                previousGrid != previous->PositionGrids.end() &&
+                std::all_of(bucket->begin(), bucket->end(), [&](uint32 index)
+                {
+                    PlayerSnapshot const& player = snapshot.Players[index];
+                    PlayerSnapshot const& old = previous->Players[index];
+                    return player.PositionX == old.PositionX && player.PositionY == old.PositionY;
+                }))
+            {
+                snapshot.PositionGrids.emplace(mapId, previousGrid->second);
+                continue;
+            }
+        }
+
+        std::shared_ptr<PlayerPositionGrid> grid = std::make_shared<PlayerPositionGrid>();
+        for (uint32 index : *bucket)
+        {
+            PlayerSnapshot const& player = snapshot.Players[index];
+            grid->Cells[PlayerPositionGrid::GetCellKey(PlayerPositionGrid::GetCell(player.PositionX), PlayerPositionGrid::GetCell(player.PositionY))].push_back(index);
+        }
+
+        snapshot.PositionGrids.emplace(mapId, std::move(grid));
+    }
+}
+
+void GameStateSnapshotMgr::BuildSnapshot()
+{
+    // Versions start from the server start time in milliseconds, so versions a
+    // client kept from an earlier run are always older than anything current
+    // and are never mistaken for a point this run can compute changes from.
+    if (!_firstVersion)
+    {
+        _version = static_cast<uint64>(GameTime::GetStartTime().count()) * 1000;
+        _firstVersion = _version + 1;
+    }
+
+    const auto& sessions = sWorldSessionMgr->GetAllSessions();
+
+    // Start a new pool once the current one mostly holds strings of players
+    // long gone. Published snapshots keep the old one for as long as they live.
+    std::shared_ptr<GameStateStringPool const> previousStrings;
+    if (_strings->GetSize() > std::max<std::size_t>(GAME_STATE_STRING_POOL_COMPACT_SIZE, sessions.size() * 12))
+    {
+        previousStrings = std::move(_strings);
+        _strings = std::make_shared<GameStateStringPool>();
+    }
+
+    std::shared_ptr<GameStateSnapshot> snapshot = std::make_shared<GameStateSnapshot>();
+    snapshot->Version = ++_version;
+    snapshot->Strings = _strings;
+    snapshot->CapturedFields = GetRequestedFields();
+    CaptureServer(snapshot->Server);
+    snapshot->Players.reserve(sessions.size());
+
+    for (const auto& [accountId, session] : sessions)
+    {
+        Player* player = session->GetPlayer();
+        if (!player || !player->IsInWorld())
+            continue;
+
+        CapturePlayer(player, snapshot->Players.emplace_back(), snapshot->CapturedFields);
+    }
+
+    std::sort(snapshot->Players.begin(), snapshot->Players.end(),
+        [](PlayerSnapshot const& left, PlayerSnapshot const& right)
+        {
+            return left.Guid.GetCounter() < right.Guid.GetCounter();
+        });
+
+    // Players already online when the hooks started counting
+    if (!_namesSeeded)
+    {
+        _names.clear();
+        for (const auto& [accountId, session] : sessions)
+            if (Player* player = session->GetPlayer())
+                _names[GameStateSnapshot::NormalizeName(player->GetName())] = player->GetGUID().GetCounter();
+
+        _namesSeeded = true;
+        _publishedNames.reset();
+    }
+
+    if (!_publishedNames)
+        _publishedNames = std::make_shared<PlayerNameIndex const>(_names);
+
+    snapshot->Names = _publishedNames;
+
+    TrackChanges(*snapshot, _previous ? previousStrings.get() : nullptr);
+    IndexPlayers(*snapshot);
+
+    _previous = snapshot;
+    Publish(std::move(snapshot));
+}
@@ -0,0 +1,532 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_GAMESTATESNAPSHOT_H
+#define GAMESTATEAPI_GAMESTATESNAPSHOT_H
+
+#include "Define.h"
+#include "Duration.h"
+#include "GameStateResponseCache.h"
+#include "MPSCQueue.h"
+#include "ObjectGuid.h"
+#include "QuestDef.h"
+#include <nlohmann/json.hpp>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class Player;
+
+// Number of visible equipment slots (EQUIPMENT_SLOT_HEAD .. EQUIPMENT_SLOT_TABARD)
+constexpr std::size_t GAME_STATE_EQUIPMENT_SLOTS = 19;
+
+// How many snapshot versions back player removals are remembered, and so how
+// old a version clients can still ask for changes against (5 minutes at the
+// default snapshot interval).
+constexpr uint64 GAME_STATE_DELTA_HISTORY = 3000;
+
+// Strings a pool may hold before the next snapshot starts a new one, with only
+// the strings still referenced. Raised to a multiple of the online players.
+constexpr uint32 GAME_STATE_STRING_POOL_COMPACT_SIZE = 64 * 1024;
+
+// Top-level members of the player document. Used to project ?fields= and to
+// skip capturing the costlier sections while nobody asks for them.
+enum PlayerFieldFlags : uint32
+{
+    PLAYER_FIELD_ACCOUNT_ID     = 0x00000001,
+    PLAYER_FIELD_ACCOUNT_NAME   = 0x00000002,
+    PLAYER_FIELD_AREA_ID        = 0x00000004,
+    PLAYER_FIELD_ARENA_POINTS   = 0x00000008,
+    PLAYER_FIELD_CLASS          = 0x00000010,
+    PLAYER_FIELD_EQUIPMENT      = 0x00000020,
+    PLAYER_FIELD_GENDER         = 0x00000040,
+    PLAYER_FIELD_GROUP          = 0x00000080,
+    PLAYER_FIELD_GUID           = 0x00000100,
+    PLAYER_FIELD_GUILD          = 0x00000200,
+    PLAYER_FIELD_HEALTH         = 0x00000400,
+    PLAYER_FIELD_HONOR_POINTS   = 0x00000800,
+    PLAYER_FIELD_LATENCY        = 0x00001000,
+    PLAYER_FIELD_LEVEL          = 0x00002000,
+    PLAYER_FIELD_MAP_ID         = 0x00004000,
+    PLAYER_FIELD_MONEY          = 0x00008000,
+    PLAYER_FIELD_NAME           = 0x00010000,
+    PLAYER_FIELD_ONLINE         = 0x00020000,
+    PLAYER_FIELD_PLAYED_TIME    = 0x00040000,
+    PLAYER_FIELD_POSITION       = 0x00080000,
+    PLAYER_FIELD_POWER          = 0x00100000,
+    PLAYER_FIELD_RACE           = 0x00200000,
+    PLAYER_FIELD_SECURITY_LEVEL = 0x00400000,
+    PLAYER_FIELD_STATS          = 0x00800000,
+    PLAYER_FIELD_STATUS         = 0x01000000,
+    PLAYER_FIELD_ZONE_ID        = 0x02000000,
+
+    PLAYER_FIELDS_ALL           = 0x03FFFFFF,
+    PLAYER_FIELDS_DEFAULT       = PLAYER_FIELDS_ALL & ~PLAYER_FIELD_EQUIPMENT, // equipment is opt-in
+
+    // Sections that walk guilds, groups or items and are only captured while requested
+    PLAYER_FIELDS_ON_DEMAND     = PLAYER_FIELD_EQUIPMENT | PLAYER_FIELD_GROUP | PLAYER_FIELD_GUILD | PLAYER_FIELD_STATS
+};
+
+// How long an on-demand section keeps being captured after the last request for it
+constexpr Seconds GAME_STATE_FIELD_DEMAND_TIMEOUT(30);
+
+// Instance fields of an equipped item. The ItemTemplate itself is immutable
+// once ObjectMgr has loaded it, so it is looked up again at serialization time.
+struct ItemSnapshot
+{
+    uint32 Entry = 0;
+    uint32 Count = 0;
+    uint32 Durability = 0;
+    uint32 MaxDurability = 0;
+
+    bool operator==(ItemSnapshot const&) const = default;
+};
+
+// Append-only pool of strings referenced by id from the snapshots. Only the
+// world thread interns; strings are stored in fixed chunks that never move, so
+// any id reachable from a published snapshot can be resolved without locking.
+// Names of players who logged out stay in it, so once it grows large the
+// manager starts a new pool; snapshots keep the pool their ids refer to alive.
+class GameStateStringPool
+{
+public:
+    GameStateStringPool();
+    ~GameStateStringPool();
+
+    GameStateStringPool(GameStateStringPool const&) = delete;
+    GameStateStringPool& operator=(GameStateStringPool const&) = delete;
+
+    // World thread only. A full pool logs an error and returns the id of the
+    // empty string rather than failing the world update.
+    uint32 Intern(std::string const& value);
+
+    uint32 GetSize() const { return _size; }
+
+    // Any thread, for ids taken from a published snapshot
+    std::string const& Get(uint32 id) const;
+
+private:
+    static constexpr uint32 CHUNK_SHIFT = 12;
+    static constexpr uint32 CHUNK_SIZE = 1 << CHUNK_SHIFT;
+    static constexpr uint32 MAX_CHUNKS = 1024;
+
+    std::array<std::atomic<std::string*>, MAX_CHUNKS> _chunks;
+    std::unordered_map<std::string, uint32> _ids;
+    uint32 _size;
+};
+
+// Copy of one in-world player, taken on the world thread. Everything is kept
+// as fixed-width fields so a copy is a few hundred bytes; JSON is produced from
+// it later on the HTTP threads.
+struct PlayerSnapshot
+{
+    // Snapshot versions in which the player entered the world and in which
+    // any of the fields below last changed
+    uint64 AddedVersion = 0;
+    uint64 ChangedVersion = 0;
+
+    ObjectGuid Guid;
+    uint32 NameId = 0;
+    uint8 Level = 0;
+    uint8 Class = 0;
+    uint8 Race = 0;
+    uint8 Gender = 0;
+    uint32 ZoneId = 0;
+    uint32 AreaId = 0;
+    uint32 MapId = 0;
+
+    bool HasSession = false;
+    uint32 AccountId = 0;
+    uint32 AccountNameId = 0;
+    uint32 Latency = 0;
+    uint32 SecurityLevel = 0;
+
+    bool HasGuild = false;
+    uint32 GuildId = 0;
+    uint32 GuildNameId = 0;
+    uint32 GuildRank = 0;
+
+    uint32 Money = 0;
+    uint32 TotalPlayedTime = 0;
+    uint32 LevelPlayedTime = 0;
+    uint32 HonorPoints = 0;
+    uint32 ArenaPoints = 0;
+
+    float PositionX = 0.0f;
+    float PositionY = 0.0f;
+    float PositionZ = 0.0f;
+    float Orientation = 0.0f;
+
+    uint32 Health = 0;
+    uint32 MaxHealth = 0;
+    uint32 PowerType = 0;
+    uint32 Power = 0;
+    uint32 MaxPower = 0;
+
+    bool HasGroup = false;
+    uint32 GroupId = 0;
+    uint32 GroupLeaderGuid = 0;
+    uint32 GroupMembersCount = 0;
+    bool IsGroupLeader = false;
+    bool IsGroupAssistant = false;
+    uint32 GroupLootMethod = 0;
+    bool IsRaidGroup = false;
+    bool IsBGGroup = false;
+    bool IsLFGGroup = false;
+
+    float Strength = 0.0f;
+    float Agility = 0.0f;
+    float Stamina = 0.0f;
+    float Intellect = 0.0f;
+    float Spirit = 0.0f;
+    float AverageItemLevel = 0.0f;
+
+    bool IsAlive = false;
+    bool IsInCombat = false;
+    bool IsGhost = false;
+    bool IsResting = false;
+    bool IsAway = false;
+    bool IsDnd = false;
+    bool IsGameMaster = false;
+
+    std::array<ItemSnapshot, GAME_STATE_EQUIPMENT_SLOTS> Equipment;
+
+    bool operator==(PlayerSnapshot const&) const = default;
+};
+
+// A player that left the world, kept so incremental consumers can drop it
+struct PlayerRemoval
+{
+    ObjectGuid Guid;
+    uint32 NameId = 0;
+    uint64 Version = 0;
+};
+
+using PlayerRemovalList = std::vector<PlayerRemoval>;
+
+// Live player data that is too large to copy every tick. These are captured
+// on demand by a world-thread query and serialized on the HTTP thread.
+struct PlayerStatsSnapshot
+{
+    uint8 Level = 0;
+    uint32 Experience = 0;
+    uint32 NextLevelExperience = 0;
+
+    float Strength = 0.0f;
+    float Agility = 0.0f;
+    float Stamina = 0.0f;
+    float Intellect = 0.0f;
+    float Spirit = 0.0f;
+
+    uint32 Health = 0;
+    uint32 MaxHealth = 0;
+    std::array<uint32, 7> Power = { };    // indexed by Powers, POWER_MANA .. POWER_RUNIC_POWER
+    std::array<uint32, 7> MaxPower = { };
+
+    float AttackPower = 0.0f;
+    float RangedAttackPower = 0.0f;
+    int32 SpellPower = 0;
+    float MeleeCritChance = 0.0f;
+    float RangedCritChance = 0.0f;
+    float SpellCritChance = 0.0f;
+    float MeleeHitChance = 0.0f;
+    float SpellHitChance = 0.0f;
+
+    uint32 Armor = 0;
+    uint32 HolyResistance = 0;
+    uint32 FireResistance = 0;
+    uint32 NatureResistance = 0;
+    uint32 FrostResistance = 0;
+    uint32 ShadowResistance = 0;
+    uint32 ArcaneResistance = 0;
+
+    bool IsAlive = false;
+    bool IsInCombat = false;
+    bool IsResting = false;
+    bool IsGhost = false;
+    bool IsPvP = false;
+    bool IsAway = false;
+    bool IsDnd = false;
+
+    float AverageItemLevel = 0.0f;
+};
+
+struct SkillLineSnapshot
+{
+    uint16 SkillId = 0;
+    uint16 SkillStep = 0;
+    uint16 Value = 0;
+    uint16 MaxValue = 0;
+    uint16 PureValue = 0;
+    int16 PermanentBonus = 0;
+    int16 TemporaryBonus = 0;
+};
+
+struct PlayerSkillsSnapshot
+{
+    std::vector<uint32> Spells; // known spell ids, in PlayerSpellMap order
+    std::vector<SkillLineSnapshot> SkillLines;
+
+    uint8 ActiveSpec = 0;
+    uint8 SpecsCount = 0;
+    uint32 FreeTalentPoints = 0;
+    uint32 UsedTalentPoints = 0;
+    uint32 TotalTalentPoints = 0;
+};
+
+struct QuestStatusSnapshot
+{
+    uint32 QuestId = 0;
+    QuestStatusData Status;
+};
+
+using PlayerQuestsSnapshot = std::vector<QuestStatusSnapshot>;
+
+struct ServerSnapshot
+{
+    int64 UptimeSeconds = 0;
+    int64 CurrentTime = 0;
+    int64 StartTime = 0;
+    uint32 PlayerCount = 0;
+    uint32 MaxPlayerCount = 0;
+    uint32 ActiveSessions = 0;
+    uint32 QueuedSessions = 0;
+    uint32 TotalSessions = 0;
+};
+
+// Normalized name -> guid counter of every player logged in, kept up to
+// date from the login and logout hooks instead of being rebuilt per snapshot
+using PlayerNameIndex = std::unordered_map<std::string, ObjectGuid::LowType>;
+
+// Secondary indexes over GameStateSnapshot::Players
+enum PlayerIndexType : uint8
+{
+    PLAYER_INDEX_MAP,
+    PLAYER_INDEX_ZONE,
+    PLAYER_INDEX_GUILD,   // only filled while PLAYER_FIELD_GUILD is captured
+    PLAYER_INDEX_GROUP,   // only filled while PLAYER_FIELD_GROUP is captured
+    MAX_PLAYER_INDEXES
+};
+
+// Players indexes (ascending, so also in guid order) sharing one key value.
+// Buckets nobody entered or left are shared with the previous snapshot.
+using PlayerIndexList = std::vector<uint32>;
+using PlayerIndexMap = std::unordered_map<uint32, std::shared_ptr<PlayerIndexList const>>;
+
+// Edge length of a PlayerPositionGrid cell, one map grid (SIZE_OF_GRIDS)
+constexpr float GAME_STATE_GRID_CELL_SIZE = 533.3333f;
+
+// Players of one map bucketed by the square cell their x/y position is in
+struct PlayerPositionGrid
+{
+    std::unordered_map<uint64, PlayerIndexList> Cells; // GetCellKey -> Players indexes
+
+    static int32 GetCell(float coordinate);
+    static uint64 GetCellKey(int32 cellX, int32 cellY);
+
+    // Calls visit with the Players index of everyone in a cell overlapping the box
+    template<typename Visit>
+    void ForEachInBox(float minX, float minY, float maxX, float maxY, Visit&& visit) const
+    {
+        int32 minCellX = GetCell(minX);
+        int32 minCellY = GetCell(minY);
+        int32 maxCellX = GetCell(maxX);
+        int32 maxCellY = GetCell(maxY);
+
+        // A box spanning more cells than are occupied is cheaper to answer by
+        // walking the occupied ones
+        uint64 boxCells = uint64(maxCellX - minCellX + 1) * uint64(maxCellY - minCellY + 1);
+        if (boxCells > Cells.size())
+        {
+            for (auto const& [key, players] : Cells)
+            {
+                int32 cellX = int32(key >> 32);
+                int32 cellY = int32(key & 0xFFFFFFFF);
+                if (cellX >= minCellX && cellX <= maxCellX && cellY >= minCellY && cellY <= maxCellY)
+                    for (uint32 index : players)
+                        visit(index);
+            }
+            return;
+        }
+
+        for (int32 cellX = minCellX; cellX <= maxCellX; ++cellX)
+        {
+            for (int32 cellY = minCellY; cellY <= maxCellY; ++cellY)
+            {
+                auto itr = Cells.find(GetCellKey(cellX, cellY));
+                if (itr != Cells.end())
+                    for (uint32 index : itr->second)
+                        visit(index);
+            }
+        }
+    }
+};
+
+// Immutable view of the world published once per snapshot interval.
+// HTTP threads only ever read through a shared_ptr<GameStateSnapshot const>.
+struct GameStateSnapshot
+{
+    uint64 Version = 0;
+    uint64 DeltaBaseVersion = 0; // oldest version changes can be computed against
+    uint64 PlayersChangedVersion = 0; // last version in which a player was added, changed or removed
+    uint32 CapturedFields = 0; // PlayerFieldFlags filled in for every player, the others are left default
+    ServerSnapshot Server;
+    std::vector<PlayerSnapshot> Players;  // sorted by guid
+    std::shared_ptr<PlayerNameIndex const> Names; // every logged in player, shared until someone logs in or out
+    std::array<PlayerIndexMap, MAX_PLAYER_INDEXES> PlayerIndexes; // key -> Players indexes, by PlayerIndexType
+    std::unordered_map<uint32, std::shared_ptr<PlayerPositionGrid const>> PositionGrids; // map id -> grid, shared while nobody on the map moved
+    std::shared_ptr<PlayerRemovalList const> RemovedPlayers; // removals after DeltaBaseVersion, oldest first
+    std::shared_ptr<GameStateStringPool const> Strings;
+    mutable GameStateResponseCache Responses; // documents rendered from this snapshot
+
+    PlayerSnapshot const* FindPlayer(std::string_view name) const;
+    PlayerSnapshot const* FindPlayerByGuid(ObjectGuid::LowType guid) const;
+    bool HasPlayer(ObjectGuid guid) const;
+
+    // Players with key in index, nullptr when there are none
+    PlayerIndexList const* FindPlayers(PlayerIndexType index, uint32 key) const;
+
+    // Position grid of mapId, nullptr when nobody is on it
+    PlayerPositionGrid const* FindPositionGrid(uint32 mapId) const;
+
+    // Whether a client that has seen version can be sent only what changed since
+    bool CanDiffFrom(uint64 version) const { return version >= DeltaBaseVersion && version <= Version; }
+    std::string const& GetString(uint32 id) const { return Strings->Get(id); }
+
+    // Lower-cases ASCII letters the same way ObjectAccessor::FindPlayerByName does
+    static std::string NormalizeName(std::string_view name);
+};
+
+using GameStateSnapshotPtr = std::shared_ptr<GameStateSnapshot const>;
+
+// Builds snapshots on the world thread and publishes them RCU style: readers
+// load the current pointer, the world thread swaps in a new one. Anything that
+// needs the live Player (stats, skills, quests) is queued as a query and
+// answered on the world thread during the next update.
+class GameStateSnapshotMgr
+{
+public:
+    static GameStateSnapshotMgr* instance();
+
+    void SetUpdateInterval(Milliseconds interval) { _updateInterval = interval; }
+
+    // World thread only
+    void Update(uint32 diff);
+    void Reset();
+
+    // World thread, from the login and logout hooks
+    void AddPlayerName(Player* player);
+    void RemovePlayerName(Player* player);
+
+    // Any thread
+    GameStateSnapshotPtr GetSnapshot() const;
+
+    // Blocks until a snapshot newer than version is published or timeout
+    // expires, then returns the current snapshot (which may not be newer)
+    GameStateSnapshotPtr WaitForSnapshot(uint64 version, Milliseconds timeout) const;
+
+    // Keeps the on-demand sections among fields captured for the next
+    // GAME_STATE_FIELD_DEMAND_TIMEOUT
+    void RequestPlayerFields(uint32 fields);
+
+    // Requests fields and returns the first snapshot that captured all of
+    // them, waiting up to timeout for one; nullptr if there is none in time
+    GameStateSnapshotPtr GetSnapshot(uint32 fields, Milliseconds timeout);
+
+    // Runs handler against the live player on the world thread. The result is
+    // empty if the player left the world before the query was answered.
+    template<typename Result>
+    std::future<std::optional<Result>> QueryPlayer(ObjectGuid guid, std::function<Result(Player*)> handler)
+    {
+        std::shared_ptr<std::promise<std::optional<Result>>> promise = std::make_shared<std::promise<std::optional<Result>>>();
+        std::future<std::optional<Result>> result = promise->get_future();
+
+        EnqueueQuery(guid, [promise, handler = std::move(handler)](Player* player)
+        {
+            if (!player)
+            {
+                promise->set_value(std::nullopt);
+                return;
+            }
+
+            try
+            {
+                promise->set_value(handler(player));
+            }
+            catch (...)
+            {
+                promise->set_exception(std::current_exception());
+            }
+        });
+
+        return result;
+    }
+
+private:
+    // Handler is called with nullptr if the player is gone or the manager resets
+    struct PlayerQuery
+    {
+        ObjectGuid Guid;
+        std::function<void(Player*)> Handler;
+    };
+
+    void EnqueueQuery(ObjectGuid guid, std::function<void(Player*)> handler);
+
+    GameStateSnapshotMgr();
+    ~GameStateSnapshotMgr();
+
+    void BuildSnapshot();
+    void CaptureServer(ServerSnapshot& server) const;
+    uint32 GetRequestedFields() const;
+    void CapturePlayer(Player* player, PlayerSnapshot& snapshot, uint32 fields);
+    // previousStrings is the pool of the previous snapshot when this one
+    // starts a new pool, so the previous ids are translated before comparing
+    void TrackChanges(GameStateSnapshot& snapshot, GameStateStringPool const* previousStrings);
+    void IndexPlayers(GameStateSnapshot& snapshot) const;
+    void Publish(GameStateSnapshotPtr snapshot);
+    void ProcessQueries();
+
+#ifdef __cpp_lib_atomic_shared_ptr
+    std::atomic<GameStateSnapshotPtr> _snapshot;
+#else
+    GameStateSnapshotPtr _snapshot; // only accessed through std::atomic_load / std::atomic_store
+#endif
+
+    mutable std::mutex _publishLock;
+    mutable std::condition_variable _published;
+
+    // steady_clock milliseconds of the last request for each on-demand field bit
+    std::array<std::atomic<int64>, 32> _fieldRequestTimes;
+
+    MPSCQueue<PlayerQuery> _queries;
+    std::shared_ptr<GameStateStringPool> _strings;
+
+    // World thread only. _names is seeded from the sessions on the first
+    // snapshot and copied into _publishedNames whenever it changed.
+    PlayerNameIndex _names;
+    std::shared_ptr<PlayerNameIndex const> _publishedNames;
+    bool _namesSeeded;
+
+    // World thread only, used to work out what changed between snapshots
+    GameStateSnapshotPtr _previous;
+    std::shared_ptr<PlayerRemovalList const> _removedPlayers;
+
+    Milliseconds _updateInterval;
+    Milliseconds _updateTimer;
+    uint64 _version;
+    uint64 _firstVersion;
+};
+
+#define sGameStateSnapshotMgr GameStateSnapshotMgr::instance()
+
+#endif // GAMESTATEAPI_GAMESTATESNAPSHOT_H
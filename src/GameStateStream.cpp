@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "GameStateStream.h"
+#include "GameStateJsonWriter.h"
+#include "GameStateUtilities.h"
+
+std::string GameStateStream::NextEvent(GameStateSnapshot const& snapshot, std::chrono::steady_clock::time_point now, EventCache* cache)
+{
+    // Snapshots taken before those sections were being captured are skipped
+    std::string event;
+    _seenVersion = snapshot.Version;
+    if (snapshot.Version > _lastVersion && (snapshot.CapturedFields & _fields) == _fields)
+    {
+        std::string* rendered = nullptr;
+        if (cache)
+        {
+            auto [itr, inserted] = cache->try_emplace({ _fields, _lastVersion });
+            if (!inserted)
+                event = itr->second;
+            else
+                rendered = &itr->second;
+        }
+
+        if (!cache || rendered)
+        {
+            bool full = !snapshot.CanDiffFrom(_lastVersion);
+
+            event = "id: " + std::to_string(snapshot.Version) + (full ? "\nevent: snapshot\ndata: " : "\nevent: delta\ndata: ");
+
+            GameStateJsonWriter writer(event);
+            std::size_t entries = 0;
+            if (full)
+                GameStateUtilities::WritePlayersFull(writer, snapshot, _fields);
+            else
+                entries = GameStateUtilities::WritePlayersDelta(writer, snapshot, _lastVersion, _fields);
+
+            // Nothing is sent for snapshots in which no player changed
+            if (full || entries)
+                event.append("\n\n");
+            else
+                event.clear();
+
+            if (rendered)
+                *rendered = event;
+        }
+
+        _lastVersion = snapshot.Version;
+    }
+
+    if (event.empty() && now - _lastWrite >= GAME_STATE_STREAM_HEARTBEAT_INTERVAL)
+        event = ": keep-alive\n\n";
+
+    if (!event.empty())
+        _lastWrite = now;
+
+    return event;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_GAMESTATESTREAM_H
+#define GAMESTATEAPI_GAMESTATESTREAM_H
+
+#include "Define.h"
+#include "Duration.h"
+#include "GameStateRequestLanes.h"
+#include "GameStateSnapshot.h"
+#include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+
+// How long a stream waits for a new snapshot before checking again whether
+// its connection was closed or the server is stopping
+constexpr Milliseconds GAME_STATE_STREAM_WAIT_TIMEOUT(1000);
+
+// Idle streams send a comment this often so proxies keep the connection open
+constexpr Seconds GAME_STATE_STREAM_HEARTBEAT_INTERVAL(15);
+
+// Position of one /api/stream subscriber in the published snapshots. Both
+// server backends drive it: the threaded one from a chunked content provider
+// per connection, the epoll one for all subscribers from a single thread.
+class GameStateStream
+{
+public:
+    // Events rendered for one snapshot, by fields and the version the
+    // subscriber had seen, so subscribers in the same position share them
+    using EventCache = std::map<std::pair<uint32, uint64>, std::string>;
+
+    GameStateStream(uint32 fields, uint64 lastVersion, GameStateRequestLanes::Slot slot)
+        : _fields(fields), _lastVersion(lastVersion), _seenVersion(lastVersion),
+        _lastWrite(std::chrono::steady_clock::now()), _slot(std::move(slot)) { }
+
+    uint32 GetFields() const { return _fields; }
+    uint64 GetSeenVersion() const { return _seenVersion; }
+
+    // The server-sent event to send for snapshot: a full snapshot or a delta
+    // if players changed, a keep-alive comment if the stream was idle for
+    // too long, otherwise nothing
+    std::string NextEvent(GameStateSnapshot const& snapshot, std::chrono::steady_clock::time_point now, EventCache* cache = nullptr);
+
+private:
+    uint32 _fields;
+    uint64 _lastVersion;
+    uint64 _seenVersion;
+    std::chrono::steady_clock::time_point _lastWrite;
+    GameStateRequestLanes::Slot _slot; // held for as long as the stream is open
+};
+
+#endif // GAMESTATEAPI_GAMESTATESTREAM_H
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "GameStateTaskQueue.h"
+#include "Log.h"
+#include <cstring>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+    thread_local bool Shedding = false;
+
+    // Connections waiting for the shedding thread to turn them away
+    constexpr std::size_t MAX_SHED_QUEUED = 1024;
+}
+
+GameStateTaskQueue::GameStateTaskQueue(std::size_t threads, std::size_t maxQueued, std::vector<uint32> cpus)
+    : _maxQueued(maxQueued), _shutdown(false), _cpus(std::move(cpus))
+{
+    _workers.reserve(threads + 1);
+    for (std::size_t i = 0; i < threads; ++i)
+        _workers.emplace_back(&GameStateTaskQueue::Work, this, std::ref(_tasks), std::ref(_wake), false);
+
+    if (_maxQueued)
+        _workers.emplace_back(&GameStateTaskQueue::Work, this, std::ref(_shedTasks), std::ref(_shedWake), true);
+}
+
+GameStateTaskQueue::~GameStateTaskQueue()
+{
+    shutdown();
+}
+
+bool GameStateTaskQueue::enqueue(std::function<void()> fn)
+{
+    {
+        std::lock_guard lock(_lock);
+        if (!_maxQueued || _tasks.size() < _maxQueued)
+        {
+            _tasks.push_back(std::move(fn));
+            _wake.notify_one();
+            return true;
+        }
+
+        // Answering 503 only takes a moment, but the shedding thread can be
+        // outrun too; past that httplib closes the connection unanswered
+        if (_shedTasks.size() >= MAX_SHED_QUEUED)
+            return false;
+
+        _shedTasks.push_back(std::move(fn));
+    }
+
+    _shedWake.notify_one();
+    return true;
+}
+
+void GameStateTaskQueue::shutdown()
+{
+    {
+        std::lock_guard lock(_lock);
+        _shutdown = true;
+    }
+
+    _wake.notify_all();
+    _shedWake.notify_all();
+
+    for (std::thread& worker : _workers)
+        if (worker.joinable())
+            worker.join();
+}
+
+bool GameStateTaskQueue::IsShedding()
+{
+    return Shedding;
+}
+
+bool GameStateTaskQueue::PinCurrentThread(std::vector<uint32> const& cpus)
+{
+    if (cpus.empty())
+        return true;
+
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (uint32 cpu : cpus)
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+
+    if (int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+    {
+        LOG_ERROR("module.gamestate_api", "Cannot pin HTTP thread to its CPUs: {}", std::strerror(error));
+        return false;
+    }
+
+    return true;
+#else
+    static std::once_flag warned;
+    std::call_once(warned, []() { LOG_WARN("module.gamestate_api", "GameStateAPI.ListenerCpus is only supported on Linux, threads are not pinned"); });
+    return false;
+#endif
+}
+
+void GameStateTaskQueue::Work(std::deque<std::function<void()>>& tasks, std::condition_variable& wake, bool shedding)
+{
+    Shedding = shedding;
+    PinCurrentThread(_cpus);
+
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(_lock);
+            wake.wait(lock, [&] { return _shutdown || !tasks.empty(); });
+
+            // Connections already accepted are still served before stopping
+            if (tasks.empty())
+                break;
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        try
+        {
+            task();
+        }
+        catch (std::exception const& e)
+        {
+            LOG_ERROR("module.gamestate_api", "HTTP worker task failed: {}", e.what());
+        }
+    }
+}
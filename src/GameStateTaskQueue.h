@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_GAMESTATETASKQUEUE_H
+#define GAMESTATEAPI_GAMESTATETASKQUEUE_H
+
+#include "Define.h"
+#include <yhirose/httplib.h>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// httplib task queue with a fixed number of workers and a bounded backlog of
+// accepted connections. A connection arriving while the backlog is full is
+// handed to a single shedding thread instead, which reads its request and
+// lets the server answer 503 right away, rather than serving it seconds late.
+// Only when the shedding backlog is full too is the connection dropped.
+class GameStateTaskQueue : public httplib::TaskQueue
+{
+public:
+    // maxQueued 0 leaves the backlog unbounded, so nothing is ever shed.
+    // The workers only run on cpus, unless it is empty.
+    GameStateTaskQueue(std::size_t threads, std::size_t maxQueued, std::vector<uint32> cpus = {});
+    ~GameStateTaskQueue() override;
+
+    bool enqueue(std::function<void()> fn) override;
+    void shutdown() override;
+
+    // True on the shedding thread, whose requests must be answered with 503
+    static bool IsShedding();
+
+    // Restrict the calling thread to cpus (nothing to do when empty); only
+    // supported on Linux, elsewhere it logs once and returns false
+    static bool PinCurrentThread(std::vector<uint32> const& cpus);
+
+private:
+    void Work(std::deque<std::function<void()>>& tasks, std::condition_variable& wake, bool shedding);
+
+    std::mutex _lock;
+    std::condition_variable _wake;
+    std::condition_variable _shedWake;
+    std::deque<std::function<void()>> _tasks;
+    std::deque<std::function<void()>> _shedTasks;
+    std::size_t _maxQueued;
+    bool _shutdown;
+    std::vector<uint32> _cpus;
+
+    std::vector<std::thread> _workers;
+};
+
+#endif // GAMESTATEAPI_GAMESTATETASKQUEUE_H
@@ -3,567 +3,1199 @@
  */
 
 #include "GameStateUtilities.h"
-#include "WorldSessionMgr.h"
-#include "GameTime.h"
+#include "GameStateFragmentCache.h"
 #include "ObjectAccessor.h"
 #include "Player.h"
 #include "SharedDefines.h"
 #include "Item.h"
 #include "ItemTemplate.h"
 #include "ObjectMgr.h"
-#include "Guild.h"
-#include "GuildMgr.h"
-#include "World.h"
-#include "Group.h"
 #include "QuestDef.h"
 #include "DBCStores.h"
 #include "SpellInfo.h"
 #include "SpellMgr.h"
 #include <fmt/format.h>
-
+#include <algorithm>
+#include <charconv>
+#include <memory>
+#include <string_view>
+
+// The Write* functions emit object keys in sorted order, which is the order
+// nlohmann::json kept them in when these documents were built as a DOM. Keep
+// it that way when adding fields so the output does not change shape.
 namespace GameStateUtilities
 {
-    nlohmann::json GetItemData(Item* item)
+    // Pre-serialized template members, see WriteItemTemplate* and WriteQuest*
+    using ItemTemplateFragment = GameStateJsonSegments<3>;
+    using QuestFragment = GameStateJsonSegments<5>;
+
+    // Castable spell listing entry, see WriteSpellData
+    struct SpellFragment
+    {
+        bool IsPassive = false;
+        std::string Json; // empty for passive spells
+    };
+
+    static GameStateFragmentCache<ItemTemplateFragment> ItemTemplateFragments;
+    static GameStateFragmentCache<QuestFragment> QuestFragments;
+    static GameStateFragmentCache<SpellFragment> SpellFragments;
+
+    void InitializeTemplateCaches()
     {
-        nlohmann::json itemData = nlohmann::json::object();
+        uint32 maxItemEntry = 0;
+        for (auto const& [entry, itemTemplate] : *sObjectMgr->GetItemTemplateStore())
+            maxItemEntry = std::max(maxItemEntry, entry);
+
+        uint32 maxQuestId = 0;
+        for (auto const& [questId, quest] : sObjectMgr->GetQuestTemplates())
+            maxQuestId = std::max(maxQuestId, questId);
+
+        ItemTemplateFragments.Resize(maxItemEntry + 1);
+        QuestFragments.Resize(maxQuestId + 1);
+        SpellFragments.Resize(sSpellMgr->GetSpellInfoStoreSize());
+    }
+
+    void ClearTemplateCaches()
+    {
+        ItemTemplateFragments.Clear();
+        QuestFragments.Clear();
+        SpellFragments.Clear();
+    }
+
+    ItemSnapshot GetItemSnapshot(Item* item)
+    {
+        ItemSnapshot snapshot;
 
         if (!item)
-            return itemData;
+            return snapshot;
 
-        const ItemTemplate* itemTemplate = item->GetTemplate();
-        if (!itemTemplate)
+        snapshot.Entry = item->GetEntry();
+        snapshot.Count = item->GetCount();
+        snapshot.Durability = item->GetUInt32Value(ITEM_FIELD_DURABILITY);
+        snapshot.MaxDurability = item->GetUInt32Value(ITEM_FIELD_MAXDURABILITY);
+
+        return snapshot;
+    }
+
+    // Members of the item object that only depend on the template, split at
+    // the per-instance fields so they can be cached: bonding .. class
+    static void WriteItemTemplateHead(GameStateJsonWriter& writer, ItemTemplate const* itemTemplate)
+    {
+        writer.Field("bonding", itemTemplate->Bonding);
+        writer.Field("buy_price", itemTemplate->BuyPrice);
+        writer.Field("class", itemTemplate->Class);
+    }
+
+    // entry .. item_set
+    static void WriteItemTemplateMiddle(GameStateJsonWriter& writer, ItemTemplate const* itemTemplate)
+    {
+        writer.Field("entry", itemTemplate->ItemId);
+        writer.Field("inventory_type", itemTemplate->InventoryType);
+        writer.Field("item_level", itemTemplate->ItemLevel);
+        writer.Field("item_set", itemTemplate->ItemSet);
+    }
+
+    // name .. weapon_data
+    static void WriteItemTemplateTail(GameStateJsonWriter& writer, ItemTemplate const* itemTemplate)
+    {
+        writer.Field("name", itemTemplate->Name1);
+        writer.Field("quality", itemTemplate->Quality);
+        writer.Field("required_level", itemTemplate->RequiredLevel);
+
+        // Resistances
+        writer.Key("resistances");
+        writer.BeginObject();
+        writer.Field("arcane", itemTemplate->ArcaneRes);
+        writer.Field("armor", itemTemplate->Armor);
+        writer.Field("fire", itemTemplate->FireRes);
+        writer.Field("frost", itemTemplate->FrostRes);
+        writer.Field("holy", itemTemplate->HolyRes);
+        writer.Field("nature", itemTemplate->NatureRes);
+        writer.Field("shadow", itemTemplate->ShadowRes);
+        writer.EndObject();
+
+        writer.Field("sell_price", itemTemplate->SellPrice);
+
+        // Gem sockets
+        bool hasSockets = false;
+        for (uint32 i = 0; i < MAX_ITEM_PROTO_SOCKETS; ++i)
         {
-            // Basic item data without template
-            itemData = {
-                {"entry", item->GetEntry()},
-                {"count", item->GetCount()},
-                {"durability", item->GetUInt32Value(ITEM_FIELD_DURABILITY)},
-                {"max_durability", item->GetUInt32Value(ITEM_FIELD_MAXDURABILITY)}
-            };
-            return itemData;
-        }
-
-        // Basic item information
-        itemData["entry"] = item->GetEntry();
-        itemData["count"] = item->GetCount();
-        itemData["name"] = itemTemplate->Name1;
-        itemData["quality"] = itemTemplate->Quality;
-        itemData["item_level"] = itemTemplate->ItemLevel;
-        itemData["required_level"] = itemTemplate->RequiredLevel;
-        itemData["class"] = itemTemplate->Class;
-        itemData["subclass"] = itemTemplate->SubClass;
-        itemData["inventory_type"] = itemTemplate->InventoryType;
-        itemData["durability"] = item->GetUInt32Value(ITEM_FIELD_DURABILITY);
-        itemData["max_durability"] = item->GetUInt32Value(ITEM_FIELD_MAXDURABILITY);
+            if (itemTemplate->Socket[i].Color)
+            {
+                hasSockets = true;
+                break;
+            }
+        }
+
+        if (hasSockets)
+        {
+            if (itemTemplate->socketBonus)
+            {
+                writer.Field("socket_bonus", itemTemplate->socketBonus);
+            }
+
+            writer.Key("sockets");
+            writer.BeginArray();
+            for (uint32 i = 0; i < MAX_ITEM_PROTO_SOCKETS; ++i)
+            {
+                if (itemTemplate->Socket[i].Color)
+                {
+                    writer.BeginObject();
+                    writer.Field("color", itemTemplate->Socket[i].Color);
+                    writer.Field("content", itemTemplate->Socket[i].Content);
+                    writer.EndObject();
+                }
+            }
+            writer.EndArray();
+        }
+
+        // Spells on item
+        bool hasSpells = false;
+        for (uint32 i = 0; i < MAX_ITEM_PROTO_SPELLS; ++i)
+        {
+            if (itemTemplate->Spells[i].SpellId > 0)
+            {
+                hasSpells = true;
+                break;
+            }
+        }
+
+        if (hasSpells)
+        {
+            writer.Key("spells");
+            writer.BeginArray();
+            for (uint32 i = 0; i < MAX_ITEM_PROTO_SPELLS; ++i)
+            {
+                if (itemTemplate->Spells[i].SpellId > 0)
+                {
+                    writer.BeginObject();
+                    writer.Field("charges", itemTemplate->Spells[i].SpellCharges);
+                    writer.Field("cooldown", itemTemplate->Spells[i].SpellCooldown);
+                    writer.Field("spell_id", itemTemplate->Spells[i].SpellId);
+                    writer.Field("trigger", itemTemplate->Spells[i].SpellTrigger);
+                    writer.EndObject();
+                }
+            }
+            writer.EndArray();
+        }
+
+        writer.Field("stack_size", itemTemplate->GetMaxStackSize());
 
         // Item stats
-        nlohmann::json stats = nlohmann::json::array();
+        writer.Key("stats");
+        writer.BeginArray();
         for (uint32 i = 0; i < itemTemplate->StatsCount && i < MAX_ITEM_PROTO_STATS; ++i)
         {
             if (itemTemplate->ItemStat[i].ItemStatValue != 0)
             {
-                stats.push_back({
-                    {"type", itemTemplate->ItemStat[i].ItemStatType},
-                    {"value", itemTemplate->ItemStat[i].ItemStatValue}
-                });
+                writer.BeginObject();
+                writer.Field("type", itemTemplate->ItemStat[i].ItemStatType);
+                writer.Field("value", itemTemplate->ItemStat[i].ItemStatValue);
+                writer.EndObject();
             }
         }
-        itemData["stats"] = stats;
+        writer.EndArray();
 
-        // Resistances
-        itemData["resistances"] = {
-            {"armor", itemTemplate->Armor},
-            {"holy", itemTemplate->HolyRes},
-            {"fire", itemTemplate->FireRes},
-            {"nature", itemTemplate->NatureRes},
-            {"frost", itemTemplate->FrostRes},
-            {"shadow", itemTemplate->ShadowRes},
-            {"arcane", itemTemplate->ArcaneRes}
-        };
+        writer.Field("subclass", itemTemplate->SubClass);
 
         // Weapon data if applicable
         if (itemTemplate->Class == ITEM_CLASS_WEAPON)
         {
-            nlohmann::json weaponData = nlohmann::json::object();
-            weaponData["delay"] = itemTemplate->Delay;
-            weaponData["dps"] = itemTemplate->getDPS();
+            writer.Key("weapon_data");
+            writer.BeginObject();
 
-            nlohmann::json damages = nlohmann::json::array();
+            writer.Key("damages");
+            writer.BeginArray();
             for (uint32 i = 0; i < MAX_ITEM_PROTO_DAMAGES; ++i)
             {
                 if (itemTemplate->Damage[i].DamageMin > 0 || itemTemplate->Damage[i].DamageMax > 0)
                 {
-                    damages.push_back({
-                        {"min", itemTemplate->Damage[i].DamageMin},
-                        {"max", itemTemplate->Damage[i].DamageMax},
-                        {"type", itemTemplate->Damage[i].DamageType}
-                    });
+                    writer.BeginObject();
+                    writer.Field("max", itemTemplate->Damage[i].DamageMax);
+                    writer.Field("min", itemTemplate->Damage[i].DamageMin);
+                    writer.Field("type", itemTemplate->Damage[i].DamageType);
+                    writer.EndObject();
                 }
             }
-            weaponData["damages"] = damages;
-            itemData["weapon_data"] = weaponData;
-        }
+            writer.EndArray();
 
-        // Gem sockets
-        nlohmann::json sockets = nlohmann::json::array();
-        for (uint32 i = 0; i < MAX_ITEM_PROTO_SOCKETS; ++i)
-        {
-            if (itemTemplate->Socket[i].Color)
-            {
-                sockets.push_back({
-                    {"color", itemTemplate->Socket[i].Color},
-                    {"content", itemTemplate->Socket[i].Content}
-                });
-            }
+            writer.Field("delay", itemTemplate->Delay);
+            writer.Field("dps", itemTemplate->getDPS());
+            writer.EndObject();
         }
-        if (!sockets.empty())
+    }
+
+    static std::unique_ptr<ItemTemplateFragment> BuildItemTemplateFragment(uint32 entry)
+    {
+        const ItemTemplate* itemTemplate = sObjectMgr->GetItemTemplate(entry);
+        if (!itemTemplate)
+            return nullptr;
+
+        return ItemTemplateFragment::Build(
+            [itemTemplate](GameStateJsonWriter& writer) { WriteItemTemplateHead(writer, itemTemplate); },
+            [itemTemplate](GameStateJsonWriter& writer) { WriteItemTemplateMiddle(writer, itemTemplate); },
+            [itemTemplate](GameStateJsonWriter& writer) { WriteItemTemplateTail(writer, itemTemplate); });
+    }
+
+    void WriteItemData(GameStateJsonWriter& writer, ItemSnapshot const& item)
+    {
+        // Cached fragments are compact, indented output is written directly
+        if (writer.IsCompact())
         {
-            itemData["sockets"] = sockets;
-            if (itemTemplate->socketBonus)
+            if (ItemTemplateFragment const* fragment = ItemTemplateFragments.Get(item.Entry, BuildItemTemplateFragment))
             {
-                itemData["socket_bonus"] = itemTemplate->socketBonus;
+                writer.BeginObject();
+                writer.Raw(fragment->Get(0));
+                writer.Field("count", item.Count);
+                writer.Field("durability", item.Durability);
+                writer.Raw(fragment->Get(1));
+                writer.Field("max_durability", item.MaxDurability);
+                writer.Raw(fragment->Get(2));
+                writer.EndObject();
+                return;
             }
         }
 
-        // Spells on item
-        nlohmann::json spells = nlohmann::json::array();
-        for (uint32 i = 0; i < MAX_ITEM_PROTO_SPELLS; ++i)
+        writer.BeginObject();
+
+        const ItemTemplate* itemTemplate = sObjectMgr->GetItemTemplate(item.Entry);
+        if (!itemTemplate)
         {
-            if (itemTemplate->Spells[i].SpellId > 0)
-            {
-                spells.push_back({
-                    {"spell_id", itemTemplate->Spells[i].SpellId},
-                    {"trigger", itemTemplate->Spells[i].SpellTrigger},
-                    {"charges", itemTemplate->Spells[i].SpellCharges},
-                    {"cooldown", itemTemplate->Spells[i].SpellCooldown}
-                });
-            }
+            // Basic item data without template
+            writer.Field("count", item.Count);
+            writer.Field("durability", item.Durability);
+            writer.Field("entry", item.Entry);
+            writer.Field("max_durability", item.MaxDurability);
+            writer.EndObject();
+            return;
         }
-        if (!spells.empty())
-        {
-            itemData["spells"] = spells;
-        }
-
-        // Additional properties
-        itemData["item_set"] = itemTemplate->ItemSet;
-        itemData["bonding"] = itemTemplate->Bonding;
-        itemData["stack_size"] = itemTemplate->GetMaxStackSize();
-        itemData["sell_price"] = itemTemplate->SellPrice;
-        itemData["buy_price"] = itemTemplate->BuyPrice;
-
-        return itemData;
-    }
-
-    nlohmann::json GetPlayerEquipment(Player* player)
-    {
-        nlohmann::json equipment = nlohmann::json::object();
-
-        if (!player)
-            return equipment;
-
-        // Equipment slot mappings using actual AzerothCore slot constants
-        const std::map<uint8, std::string> slotNames = {
-            {EQUIPMENT_SLOT_HEAD, "head"},
-            {EQUIPMENT_SLOT_NECK, "neck"},
-            {EQUIPMENT_SLOT_SHOULDERS, "shoulders"},
-            {EQUIPMENT_SLOT_BODY, "body"},
-            {EQUIPMENT_SLOT_CHEST, "chest"},
-            {EQUIPMENT_SLOT_WAIST, "waist"},
-            {EQUIPMENT_SLOT_LEGS, "legs"},
-            {EQUIPMENT_SLOT_FEET, "feet"},
-            {EQUIPMENT_SLOT_WRISTS, "wrists"},
-            {EQUIPMENT_SLOT_HANDS, "hands"},
-            {EQUIPMENT_SLOT_FINGER1, "finger1"},
-            {EQUIPMENT_SLOT_FINGER2, "finger2"},
-            {EQUIPMENT_SLOT_TRINKET1, "trinket1"},
-            {EQUIPMENT_SLOT_TRINKET2, "trinket2"},
-            {EQUIPMENT_SLOT_BACK, "back"},
-            {EQUIPMENT_SLOT_MAINHAND, "mainhand"},
-            {EQUIPMENT_SLOT_OFFHAND, "offhand"},
-            {EQUIPMENT_SLOT_RANGED, "ranged"},
-            {EQUIPMENT_SLOT_TABARD, "tabard"}
-        };
 
-        for (const auto& [slot, name] : slotNames)
+        WriteItemTemplateHead(writer, itemTemplate);
+        writer.Field("count", item.Count);
+        writer.Field("durability", item.Durability);
+        WriteItemTemplateMiddle(writer, itemTemplate);
+        writer.Field("max_durability", item.MaxDurability);
+        WriteItemTemplateTail(writer, itemTemplate);
+
+        writer.EndObject();
+    }
+
+    void WritePlayerEquipment(GameStateJsonWriter& writer, std::array<ItemSnapshot, GAME_STATE_EQUIPMENT_SLOTS> const& items)
+    {
+        // Equipment slot mappings using actual AzerothCore slot constants, sorted by name
+        static const std::array<std::pair<char const*, uint8>, GAME_STATE_EQUIPMENT_SLOTS> slotNames = {{
+            {"back", EQUIPMENT_SLOT_BACK},
+            {"body", EQUIPMENT_SLOT_BODY},
+            {"chest", EQUIPMENT_SLOT_CHEST},
+            {"feet", EQUIPMENT_SLOT_FEET},
+            {"finger1", EQUIPMENT_SLOT_FINGER1},
+            {"finger2", EQUIPMENT_SLOT_FINGER2},
+            {"hands", EQUIPMENT_SLOT_HANDS},
+            {"head", EQUIPMENT_SLOT_HEAD},
+            {"legs", EQUIPMENT_SLOT_LEGS},
+            {"mainhand", EQUIPMENT_SLOT_MAINHAND},
+            {"neck", EQUIPMENT_SLOT_NECK},
+            {"offhand", EQUIPMENT_SLOT_OFFHAND},
+            {"ranged", EQUIPMENT_SLOT_RANGED},
+            {"shoulders", EQUIPMENT_SLOT_SHOULDERS},
+            {"tabard", EQUIPMENT_SLOT_TABARD},
+            {"trinket1", EQUIPMENT_SLOT_TRINKET1},
+            {"trinket2", EQUIPMENT_SLOT_TRINKET2},
+            {"waist", EQUIPMENT_SLOT_WAIST},
+            {"wrists", EQUIPMENT_SLOT_WRISTS}
+        }};
+
+        writer.BeginObject();
+        for (const auto& [name, slot] : slotNames)
         {
-            if (Item* item = player->GetItemByPos(INVENTORY_SLOT_BAG_0, slot))
+            writer.Key(name);
+            if (items[slot].Entry)
             {
-                equipment[name] = GetItemData(item);
+                WriteItemData(writer, items[slot]);
             }
             else
             {
-                equipment[name] = nullptr;
+                writer.Null();
             }
         }
-
-        return equipment;
+        writer.EndObject();
     }
 
-    nlohmann::json GetPlayerStats(Player* player)
+    PlayerStatsSnapshot GetPlayerStatsSnapshot(Player* player)
     {
-        nlohmann::json stats = nlohmann::json::object();
-
-        if (!player)
-            return stats;
+        PlayerStatsSnapshot stats;
 
         // Basic character stats
-        stats["level"] = player->GetLevel();
-        stats["experience"] = {
-            {"current", player->GetUInt32Value(PLAYER_XP)},
-            {"next_level", player->GetUInt32Value(PLAYER_NEXT_LEVEL_XP)}
-        };
+        stats.Level = player->GetLevel();
+        stats.Experience = player->GetUInt32Value(PLAYER_XP);
+        stats.NextLevelExperience = player->GetUInt32Value(PLAYER_NEXT_LEVEL_XP);
 
         // Primary stats
-        stats["attributes"] = {
-            {"strength", player->GetStat(STAT_STRENGTH)},
-            {"agility", player->GetStat(STAT_AGILITY)},
-            {"stamina", player->GetStat(STAT_STAMINA)},
-            {"intellect", player->GetStat(STAT_INTELLECT)},
-            {"spirit", player->GetStat(STAT_SPIRIT)}
-        };
-
-        // Health and power
-        stats["health"] = {
-            {"current", player->GetHealth()},
-            {"max", player->GetMaxHealth()}
-        };
-
-        // All power types
-        stats["power"] = {
-            {"mana", {
-                {"current", player->GetPower(POWER_MANA)},
-                {"max", player->GetMaxPower(POWER_MANA)}
-            }},
-            {"rage", {
-                {"current", player->GetPower(POWER_RAGE)},
-                {"max", player->GetMaxPower(POWER_RAGE)}
-            }},
-            {"energy", {
-                {"current", player->GetPower(POWER_ENERGY)},
-                {"max", player->GetMaxPower(POWER_ENERGY)}
-            }},
-            {"focus", {
-                {"current", player->GetPower(POWER_FOCUS)},
-                {"max", player->GetMaxPower(POWER_FOCUS)}
-            }},
-            {"happiness", {
-                {"current", player->GetPower(POWER_HAPPINESS)},
-                {"max", player->GetMaxPower(POWER_HAPPINESS)}
-            }},
-            {"runes", {
-                {"current", player->GetPower(POWER_RUNE)},
-                {"max", player->GetMaxPower(POWER_RUNE)}
-            }},
-            {"runic_power", {
-                {"current", player->GetPower(POWER_RUNIC_POWER)},
-                {"max", player->GetMaxPower(POWER_RUNIC_POWER)}
-            }}
-        };
+        stats.Strength = player->GetStat(STAT_STRENGTH);
+        stats.Agility = player->GetStat(STAT_AGILITY);
+        stats.Stamina = player->GetStat(STAT_STAMINA);
+        stats.Intellect = player->GetStat(STAT_INTELLECT);
+        stats.Spirit = player->GetStat(STAT_SPIRIT);
+
+        // Health and all power types
+        stats.Health = player->GetHealth();
+        stats.MaxHealth = player->GetMaxHealth();
+        for (Powers power : { POWER_MANA, POWER_RAGE, POWER_FOCUS, POWER_ENERGY, POWER_HAPPINESS, POWER_RUNE, POWER_RUNIC_POWER })
+        {
+            stats.Power[power] = player->GetPower(power);
+            stats.MaxPower[power] = player->GetMaxPower(power);
+        }
 
         // Combat stats
-        stats["combat"] = {
-            {"attack_power", player->GetTotalAttackPowerValue(BASE_ATTACK)},
-            {"ranged_attack_power", player->GetTotalAttackPowerValue(RANGED_ATTACK)},
-            {"spell_power", player->GetBaseSpellPowerBonus()},
-            {"critical_chance", {
-                {"melee", player->GetFloatValue(PLAYER_CRIT_PERCENTAGE)},
-                {"ranged", player->GetFloatValue(PLAYER_RANGED_CRIT_PERCENTAGE)},
-                {"spell", player->GetFloatValue(PLAYER_SPELL_CRIT_PERCENTAGE1)}
-            }},
-            {"hit_chance", {
-                {"melee", player->GetFloatValue(PLAYER_FIELD_MOD_TARGET_PHYSICAL_RESISTANCE)},
-                {"spell", player->GetFloatValue(PLAYER_FIELD_MOD_TARGET_RESISTANCE)}
-            }}
-        };
+        stats.AttackPower = player->GetTotalAttackPowerValue(BASE_ATTACK);
+        stats.RangedAttackPower = player->GetTotalAttackPowerValue(RANGED_ATTACK);
+        stats.SpellPower = player->GetBaseSpellPowerBonus();
+        stats.MeleeCritChance = player->GetFloatValue(PLAYER_CRIT_PERCENTAGE);
+        stats.RangedCritChance = player->GetFloatValue(PLAYER_RANGED_CRIT_PERCENTAGE);
+        stats.SpellCritChance = player->GetFloatValue(PLAYER_SPELL_CRIT_PERCENTAGE1);
+        stats.MeleeHitChance = player->GetFloatValue(PLAYER_FIELD_MOD_TARGET_PHYSICAL_RESISTANCE);
+        stats.SpellHitChance = player->GetFloatValue(PLAYER_FIELD_MOD_TARGET_RESISTANCE);
 
         // Resistances
-        stats["resistances"] = {
-            {"armor", player->GetArmor()},
-            {"holy", player->GetResistance(SPELL_SCHOOL_HOLY)},
-            {"fire", player->GetResistance(SPELL_SCHOOL_FIRE)},
-            {"nature", player->GetResistance(SPELL_SCHOOL_NATURE)},
-            {"frost", player->GetResistance(SPELL_SCHOOL_FROST)},
-            {"shadow", player->GetResistance(SPELL_SCHOOL_SHADOW)},
-            {"arcane", player->GetResistance(SPELL_SCHOOL_ARCANE)}
-        };
+        stats.Armor = player->GetArmor();
+        stats.HolyResistance = player->GetResistance(SPELL_SCHOOL_HOLY);
+        stats.FireResistance = player->GetResistance(SPELL_SCHOOL_FIRE);
+        stats.NatureResistance = player->GetResistance(SPELL_SCHOOL_NATURE);
+        stats.FrostResistance = player->GetResistance(SPELL_SCHOOL_FROST);
+        stats.ShadowResistance = player->GetResistance(SPELL_SCHOOL_SHADOW);
+        stats.ArcaneResistance = player->GetResistance(SPELL_SCHOOL_ARCANE);
 
         // Status information
-        stats["status"] = {
-            {"alive", player->IsAlive()},
-            {"in_combat", player->IsInCombat()},
-            {"resting", player->HasPlayerFlag(PLAYER_FLAGS_RESTING)},
-            {"ghost", player->HasFlag(PLAYER_FLAGS, PLAYER_FLAGS_GHOST)},
-            {"player_vs_player", player->HasFlag(PLAYER_FLAGS, PLAYER_FLAGS_PVP_TIMER)},
-            {"away", player->isAFK()},
-            {"dnd", player->isDND()}
-        };
+        stats.IsAlive = player->IsAlive();
+        stats.IsInCombat = player->IsInCombat();
+        stats.IsResting = player->HasPlayerFlag(PLAYER_FLAGS_RESTING);
+        stats.IsGhost = player->HasFlag(PLAYER_FLAGS, PLAYER_FLAGS_GHOST);
+        stats.IsPvP = player->HasFlag(PLAYER_FLAGS, PLAYER_FLAGS_PVP_TIMER);
+        stats.IsAway = player->isAFK();
+        stats.IsDnd = player->isDND();
 
         // Average item level
-        stats["average_item_level"] = player->GetAverageItemLevel();
+        stats.AverageItemLevel = player->GetAverageItemLevel();
 
         return stats;
     }
 
-    nlohmann::json GetPlayerTalentInfo(Player* player)
+    void WritePlayerStats(GameStateJsonWriter& writer, PlayerStatsSnapshot const& stats)
     {
-        nlohmann::json talents = nlohmann::json::object();
+        // All power types, sorted by name
+        static const std::array<std::pair<char const*, Powers>, 7> powerNames = {{
+            {"energy", POWER_ENERGY},
+            {"focus", POWER_FOCUS},
+            {"happiness", POWER_HAPPINESS},
+            {"mana", POWER_MANA},
+            {"rage", POWER_RAGE},
+            {"runes", POWER_RUNE},
+            {"runic_power", POWER_RUNIC_POWER}
+        }};
+
+        writer.BeginObject();
 
-        if (!player)
-            return talents;
+        // Primary stats
+        writer.Key("attributes");
+        writer.BeginObject();
+        writer.Field("agility", stats.Agility);
+        writer.Field("intellect", stats.Intellect);
+        writer.Field("spirit", stats.Spirit);
+        writer.Field("stamina", stats.Stamina);
+        writer.Field("strength", stats.Strength);
+        writer.EndObject();
 
-        talents["active_spec"] = player->GetActiveSpec();
-        talents["specs_count"] = player->GetSpecsCount();
+        writer.Field("average_item_level", stats.AverageItemLevel);
 
-        // Get talent points spent in each tree
-        // Note: This is a simplified version, full talent tree data would require more complex implementation
-        uint32 totalTalentPoints = player->CalculateTalentsPoints();
-        uint32 freeTalentPoints = player->GetFreeTalentPoints();
-        uint32 usedTalentPoints = (totalTalentPoints >= freeTalentPoints) ? (totalTalentPoints - freeTalentPoints) : 0;
-
-        talents["talent_points"] = {
-            {"available", freeTalentPoints},
-            {"used", usedTalentPoints},
-            {"total", totalTalentPoints}
-        };
+        // Combat stats
+        writer.Key("combat");
+        writer.BeginObject();
+        writer.Field("attack_power", stats.AttackPower);
+        writer.Key("critical_chance");
+        writer.BeginObject();
+        writer.Field("melee", stats.MeleeCritChance);
+        writer.Field("ranged", stats.RangedCritChance);
+        writer.Field("spell", stats.SpellCritChance);
+        writer.EndObject();
+        writer.Key("hit_chance");
+        writer.BeginObject();
+        writer.Field("melee", stats.MeleeHitChance);
+        writer.Field("spell", stats.SpellHitChance);
+        writer.EndObject();
+        writer.Field("ranged_attack_power", stats.RangedAttackPower);
+        writer.Field("spell_power", stats.SpellPower);
+        writer.EndObject();
+
+        writer.Key("experience");
+        writer.BeginObject();
+        writer.Field("current", stats.Experience);
+        writer.Field("next_level", stats.NextLevelExperience);
+        writer.EndObject();
+
+        // Health and power
+        writer.Key("health");
+        writer.BeginObject();
+        writer.Field("current", stats.Health);
+        writer.Field("max", stats.MaxHealth);
+        writer.EndObject();
+
+        writer.Field("level", stats.Level);
+
+        writer.Key("power");
+        writer.BeginObject();
+        for (const auto& [name, power] : powerNames)
+        {
+            writer.Key(name);
+            writer.BeginObject();
+            writer.Field("current", stats.Power[power]);
+            writer.Field("max", stats.MaxPower[power]);
+            writer.EndObject();
+        }
+        writer.EndObject();
+
+        // Resistances
+        writer.Key("resistances");
+        writer.BeginObject();
+        writer.Field("arcane", stats.ArcaneResistance);
+        writer.Field("armor", stats.Armor);
+        writer.Field("fire", stats.FireResistance);
+        writer.Field("frost", stats.FrostResistance);
+        writer.Field("holy", stats.HolyResistance);
+        writer.Field("nature", stats.NatureResistance);
+        writer.Field("shadow", stats.ShadowResistance);
+        writer.EndObject();
 
-        return talents;
+        // Status information
+        writer.Key("status");
+        writer.BeginObject();
+        writer.Field("alive", stats.IsAlive);
+        writer.Field("away", stats.IsAway);
+        writer.Field("dnd", stats.IsDnd);
+        writer.Field("ghost", stats.IsGhost);
+        writer.Field("in_combat", stats.IsInCombat);
+        writer.Field("player_vs_player", stats.IsPvP);
+        writer.Field("resting", stats.IsResting);
+        writer.EndObject();
+
+        writer.EndObject();
     }
 
-    nlohmann::json GetPlayerData(Player* player, bool includeEquipment)
+    void WritePlayerData(GameStateJsonWriter& writer, GameStateSnapshot const& snapshot, PlayerSnapshot const& player, uint32 fields)
     {
-        nlohmann::json data = nlohmann::json::object();
+        writer.BeginObject();
+
+        // Account and session info
+        if (player.HasSession)
+        {
+            if (fields & PLAYER_FIELD_ACCOUNT_ID)
+                writer.Field("account_id", player.AccountId);
+            if (fields & PLAYER_FIELD_ACCOUNT_NAME)
+                writer.Field("account_name", snapshot.GetString(player.AccountNameId));
+        }
 
-        if (!player)
-            return data;
+        if (fields & PLAYER_FIELD_AREA_ID)
+            writer.Field("area_id", player.AreaId);
+        if (fields & PLAYER_FIELD_ARENA_POINTS)
+            writer.Field("arena_points", player.ArenaPoints);
+        if (fields & PLAYER_FIELD_CLASS)
+            writer.Field("class", player.Class);
 
-        WorldSession* session = player->GetSession();
+        if (fields & PLAYER_FIELD_EQUIPMENT)
+        {
+            writer.Key("equipment");
+            WritePlayerEquipment(writer, player.Equipment);
+        }
 
-        data["name"] = player->GetName();
-        data["level"] = player->GetLevel();
-        data["class"] = player->getClass();
-        data["race"] = player->getRace();
-        data["gender"] = player->getGender();
-        data["guid"] = player->GetGUID().GetCounter();
-        data["zone_id"] = player->GetZoneId();
-        data["area_id"] = player->GetAreaId();
-        data["map_id"] = player->GetMapId();
-        data["online"] = true; // If we have a Player object, they're online
+        if (fields & PLAYER_FIELD_GENDER)
+            writer.Field("gender", player.Gender);
 
-        // Account and session info
-        if (session)
+        // Group information
+        if (fields & PLAYER_FIELD_GROUP)
         {
-            data["account_id"] = session->GetAccountId();
-            data["account_name"] = session->GetPlayerName();
-            data["latency"] = session->GetLatency();
-            data["security_level"] = static_cast<uint32>(session->GetSecurity());
+            writer.Key("group");
+            if (player.HasGroup)
+            {
+                writer.BeginObject();
+                writer.Field("id", player.GroupId);
+                writer.Field("is_assistant", player.IsGroupAssistant);
+                writer.Field("is_bg_group", player.IsBGGroup);
+                writer.Field("is_leader", player.IsGroupLeader);
+                writer.Field("is_lfg_group", player.IsLFGGroup);
+                writer.Field("is_raid", player.IsRaidGroup);
+                writer.Field("leader_guid", player.GroupLeaderGuid);
+                writer.Field("loot_method", player.GroupLootMethod);
+                writer.Field("members_count", player.GroupMembersCount);
+                writer.EndObject();
+            }
+            else
+            {
+                writer.Null();
+            }
         }
 
+        if (fields & PLAYER_FIELD_GUID)
+            writer.Field("guid", player.Guid.GetCounter());
+
         // Guild information
-        if (Guild* guild = sGuildMgr->GetGuildById(player->GetGuildId()))
+        if (fields & PLAYER_FIELD_GUILD)
         {
-            data["guild"] = {
-                {"id", player->GetGuildId()},
-                {"name", guild->GetName()},
-                {"rank", player->GetRank()}
-            };
+            writer.Key("guild");
+            if (player.HasGuild)
+            {
+                writer.BeginObject();
+                writer.Field("id", player.GuildId);
+                writer.Field("name", snapshot.GetString(player.GuildNameId));
+                writer.Field("rank", player.GuildRank);
+                writer.EndObject();
+            }
+            else
+            {
+                writer.Null();
+            }
         }
-        else
+
+        // Health and power
+        if (fields & PLAYER_FIELD_HEALTH)
         {
-            data["guild"] = nullptr;
+            writer.Key("health");
+            writer.BeginObject();
+            writer.Field("current", player.Health);
+            writer.Field("max", player.MaxHealth);
+            writer.EndObject();
         }
 
-        // Additional character data
-        data["money"] = player->GetMoney();
-        data["played_time"] = {
-            {"total", player->GetTotalPlayedTime()},
-            {"level", player->GetLevelPlayedTime()}
-        };
-        data["honor_points"] = player->GetHonorPoints();
-        data["arena_points"] = player->GetArenaPoints();
+        if (fields & PLAYER_FIELD_HONOR_POINTS)
+            writer.Field("honor_points", player.HonorPoints);
 
-        // Position information
-        data["position"] = {
-            {"x", player->GetPositionX()},
-            {"y", player->GetPositionY()},
-            {"z", player->GetPositionZ()},
-            {"orientation", player->GetOrientation()}
-        };
+        if (player.HasSession && (fields & PLAYER_FIELD_LATENCY))
+        {
+            writer.Field("latency", player.Latency);
+        }
 
-        // Health and power
-        data["health"] = {
-            {"current", player->GetHealth()},
-            {"max", player->GetMaxHealth()}
-        };
+        if (fields & PLAYER_FIELD_LEVEL)
+            writer.Field("level", player.Level);
+        if (fields & PLAYER_FIELD_MAP_ID)
+            writer.Field("map_id", player.MapId);
+        if (fields & PLAYER_FIELD_MONEY)
+            writer.Field("money", player.Money);
+        if (fields & PLAYER_FIELD_NAME)
+            writer.Field("name", snapshot.GetString(player.NameId));
+        if (fields & PLAYER_FIELD_ONLINE)
+            writer.Field("online", true); // Only in-world players are snapshotted
+
+        if (fields & PLAYER_FIELD_PLAYED_TIME)
+        {
+            writer.Key("played_time");
+            writer.BeginObject();
+            writer.Field("level", player.LevelPlayedTime);
+            writer.Field("total", player.TotalPlayedTime);
+            writer.EndObject();
+        }
 
-        Powers primaryPower = player->getPowerType();
-        data["power"] = {
-            {"type", static_cast<uint32>(primaryPower)},
-            {"current", player->GetPower(primaryPower)},
-            {"max", player->GetMaxPower(primaryPower)}
-        };
+        // Position information
+        if (fields & PLAYER_FIELD_POSITION)
+        {
+            writer.Key("position");
+            writer.BeginObject();
+            writer.Field("orientation", player.Orientation);
+            writer.Field("x", player.PositionX);
+            writer.Field("y", player.PositionY);
+            writer.Field("z", player.PositionZ);
+            writer.EndObject();
+        }
 
-        // Group information
-        if (Group* group = player->GetGroup())
-        {
-            data["group"] = {
-                {"id", group->GetGUID().GetCounter()},
-                {"leader_guid", group->GetLeaderGUID().GetCounter()},
-                {"members_count", group->GetMembersCount()},
-                {"is_leader", group->IsLeader(player->GetGUID())},
-                {"is_assistant", group->IsAssistant(player->GetGUID())},
-                {"loot_method", static_cast<uint32>(group->GetLootMethod())},
-                {"is_raid", group->isRaidGroup()},
-                {"is_bg_group", group->isBGGroup()},
-                {"is_lfg_group", group->isLFGGroup()}
-            };
+        if (fields & PLAYER_FIELD_POWER)
+        {
+            writer.Key("power");
+            writer.BeginObject();
+            writer.Field("current", player.Power);
+            writer.Field("max", player.MaxPower);
+            writer.Field("type", player.PowerType);
+            writer.EndObject();
         }
-        else
+
+        if (fields & PLAYER_FIELD_RACE)
+            writer.Field("race", player.Race);
+
+        if (player.HasSession && (fields & PLAYER_FIELD_SECURITY_LEVEL))
         {
-            data["group"] = nullptr;
+            writer.Field("security_level", player.SecurityLevel);
         }
 
         // Get basic stats without detailed breakdown
-        data["stats"] = {
-            {"strength", player->GetStat(STAT_STRENGTH)},
-            {"agility", player->GetStat(STAT_AGILITY)},
-            {"stamina", player->GetStat(STAT_STAMINA)},
-            {"intellect", player->GetStat(STAT_INTELLECT)},
-            {"spirit", player->GetStat(STAT_SPIRIT)},
-            {"average_item_level", player->GetAverageItemLevel()}
-        };
+        if (fields & PLAYER_FIELD_STATS)
+        {
+            writer.Key("stats");
+            writer.BeginObject();
+            writer.Field("agility", player.Agility);
+            writer.Field("average_item_level", player.AverageItemLevel);
+            writer.Field("intellect", player.Intellect);
+            writer.Field("spirit", player.Spirit);
+            writer.Field("stamina", player.Stamina);
+            writer.Field("strength", player.Strength);
+            writer.EndObject();
+        }
 
         // Status flags
-        data["status"] = {
-            {"alive", player->IsAlive()},
-            {"in_combat", player->IsInCombat()},
-            {"ghost", player->HasFlag(PLAYER_FLAGS, PLAYER_FLAGS_GHOST)},
-            {"resting", player->HasPlayerFlag(PLAYER_FLAGS_RESTING)},
-            {"away", player->isAFK()},
-            {"dnd", player->isDND()},
-            {"gm", player->IsGameMaster()}
-        };
-
-        if (includeEquipment)
+        if (fields & PLAYER_FIELD_STATUS)
         {
-            data["equipment"] = GetPlayerEquipment(player);
+            writer.Key("status");
+            writer.BeginObject();
+            writer.Field("alive", player.IsAlive);
+            writer.Field("away", player.IsAway);
+            writer.Field("dnd", player.IsDnd);
+            writer.Field("ghost", player.IsGhost);
+            writer.Field("gm", player.IsGameMaster);
+            writer.Field("in_combat", player.IsInCombat);
+            writer.Field("resting", player.IsResting);
+            writer.EndObject();
         }
 
-        return data;
+        if (fields & PLAYER_FIELD_ZONE_ID)
+            writer.Field("zone_id", player.ZoneId);
+
+        writer.EndObject();
     }
 
-    nlohmann::json GetServerData()
+    bool ParsePlayerFields(std::string_view list, uint32& fields)
     {
-        nlohmann::json data = nlohmann::json::object();
+        // Sorted by name for the binary search below
+        static constexpr std::pair<std::string_view, uint32> FieldNames[] =
+        {
+            { "account_id",     PLAYER_FIELD_ACCOUNT_ID },
+            { "account_name",   PLAYER_FIELD_ACCOUNT_NAME },
+            { "area_id",        PLAYER_FIELD_AREA_ID },
+            { "arena_points",   PLAYER_FIELD_ARENA_POINTS },
+            { "class",          PLAYER_FIELD_CLASS },
+            { "equipment",      PLAYER_FIELD_EQUIPMENT },
+            { "gender",         PLAYER_FIELD_GENDER },
+            { "group",          PLAYER_FIELD_GROUP },
+            { "guid",           PLAYER_FIELD_GUID },
+            { "guild",          PLAYER_FIELD_GUILD },
+            { "health",         PLAYER_FIELD_HEALTH },
+            { "honor_points",   PLAYER_FIELD_HONOR_POINTS },
+            { "latency",        PLAYER_FIELD_LATENCY },
+            { "level",          PLAYER_FIELD_LEVEL },
+            { "map_id",         PLAYER_FIELD_MAP_ID },
+            { "money",          PLAYER_FIELD_MONEY },
+            { "name",           PLAYER_FIELD_NAME },
+            { "online",         PLAYER_FIELD_ONLINE },
+            { "played_time",    PLAYER_FIELD_PLAYED_TIME },
+            { "position",       PLAYER_FIELD_POSITION },
+            { "power",          PLAYER_FIELD_POWER },
+            { "race",           PLAYER_FIELD_RACE },
+            { "security_level", PLAYER_FIELD_SECURITY_LEVEL },
+            { "stats",          PLAYER_FIELD_STATS },
+            { "status",         PLAYER_FIELD_STATUS },
+            { "zone_id",        PLAYER_FIELD_ZONE_ID }
+        };
 
-        Seconds uptime = GameTime::GetUptime();
-        Seconds currentTime = GameTime::GetGameTime();
-        Seconds startTime = GameTime::GetStartTime();
+        fields = 0;
+        while (!list.empty())
+        {
+            std::size_t end = list.find(',');
+            std::string_view name = list.substr(0, end);
+            list = end == std::string_view::npos ? std::string_view() : list.substr(end + 1);
+
+            auto itr = std::lower_bound(std::begin(FieldNames), std::end(FieldNames), name,
+                [](std::pair<std::string_view, uint32> const& field, std::string_view value) { return field.first < value; });
+            if (itr == std::end(FieldNames) || itr->first != name)
+                return false;
 
-        data["uptime_seconds"] = uptime.count();
-        data["current_time"] = currentTime.count();
-        data["start_time"] = startTime.count();
-        data["player_count"] = sWorldSessionMgr->GetPlayerCount();
-        data["max_player_count"] = sWorldSessionMgr->GetMaxPlayerCount();
-        data["active_sessions"] = sWorldSessionMgr->GetActiveSessionCount();
-        data["queued_sessions"] = sWorldSessionMgr->GetQueuedSessionCount();
-        data["total_sessions"] = sWorldSessionMgr->GetActiveAndQueuedSessionCount();
+            fields |= itr->second;
+        }
 
+        return fields != 0;
+    }
+
+    void WriteServerData(GameStateJsonWriter& writer, ServerSnapshot const& server)
+    {
         // Format uptime as human-readable
-        uint32 uptimeSeconds = static_cast<uint32>(uptime.count());
+        uint32 uptimeSeconds = static_cast<uint32>(server.UptimeSeconds);
         uint32 days = uptimeSeconds / 86400;
         uint32 hours = (uptimeSeconds % 86400) / 3600;
         uint32 minutes = (uptimeSeconds % 3600) / 60;
         uint32 seconds = uptimeSeconds % 60;
 
-        data["uptime_formatted"] = fmt::format("{}d {}h {}m {}s", days, hours, minutes, seconds);
+        writer.BeginObject();
+        writer.Field("active_sessions", server.ActiveSessions);
+        writer.Field("current_time", server.CurrentTime);
+        writer.Field("max_player_count", server.MaxPlayerCount);
+        writer.Field("player_count", server.PlayerCount);
+        writer.Field("queued_sessions", server.QueuedSessions);
+        writer.Field("start_time", server.StartTime);
+        writer.Field("total_sessions", server.TotalSessions);
+        writer.Field("uptime_formatted", fmt::format("{}d {}h {}m {}s", days, hours, minutes, seconds));
+        writer.Field("uptime_seconds", server.UptimeSeconds);
+        writer.EndObject();
+    }
 
-        return data;
+    void WriteAllPlayersData(GameStateJsonWriter& writer, GameStateSnapshot const& snapshot, uint32 fields)
+    {
+        writer.BeginArray();
+        for (PlayerSnapshot const& player : snapshot.Players)
+        {
+            WritePlayerData(writer, snapshot, player, fields);
+        }
+        writer.EndArray();
     }
 
-    nlohmann::json GetAllPlayersData(bool includeEquipment)
+    void WritePlayersFull(GameStateJsonWriter& writer, GameStateSnapshot const& snapshot, uint32 fields)
     {
-        nlohmann::json players = nlohmann::json::array();
+        writer.BeginObject();
+        writer.Field("count", snapshot.Players.size());
+        writer.Field("full", true);
+        writer.Key("players");
+        WriteAllPlayersData(writer, snapshot, fields);
+        writer.Field("version", snapshot.Version);
+        writer.EndObject();
+    }
 
-        const auto& sessions = sWorldSessionMgr->GetAllSessions();
-        for (const auto& [accountId, session] : sessions)
+    std::size_t WritePlayersDelta(GameStateJsonWriter& writer, GameStateSnapshot const& snapshot, uint64 since, uint32 fields)
+    {
+        std::size_t entries = 0;
+
+        writer.BeginObject();
+
+        writer.Key("added");
+        writer.BeginArray();
+        for (PlayerSnapshot const& player : snapshot.Players)
         {
-            if (Player* player = session->GetPlayer())
+            if (player.AddedVersion > since)
             {
-                // Only include players that are actually in world
-                if (player->IsInWorld())
-                {
-                    players.push_back(GetPlayerData(player, includeEquipment));
-                }
+                WritePlayerData(writer, snapshot, player, fields);
+                ++entries;
+            }
+        }
+        writer.EndArray();
+
+        writer.Key("changed");
+        writer.BeginArray();
+        for (PlayerSnapshot const& player : snapshot.Players)
+        {
+            if (player.AddedVersion <= since && player.ChangedVersion > since)
+            {
+                WritePlayerData(writer, snapshot, player, fields);
+                ++entries;
+            }
+        }
+        writer.EndArray();
+
+        writer.Field("full", false);
+
+        writer.Key("removed");
+        writer.BeginArray();
+        if (snapshot.RemovedPlayers)
+        {
+            for (PlayerRemoval const& removal : *snapshot.RemovedPlayers)
+            {
+                // A player that logged back in is reported as added instead
+                if (removal.Version <= since || snapshot.HasPlayer(removal.Guid))
+                    continue;
+
+                writer.BeginObject();
+                writer.Field("guid", removal.Guid.GetCounter());
+                writer.Field("name", snapshot.GetString(removal.NameId));
+                writer.EndObject();
+                ++entries;
             }
         }
+        writer.EndArray();
+
+        writer.Field("since", since);
+        writer.Field("version", snapshot.Version);
 
-        return players;
+        writer.EndObject();
+
+        return entries;
     }
 
-    Player* FindPlayerByName(const std::string& name)
+    static constexpr std::pair<std::string_view, PlayerSortKey> PlayerSortNames[] =
     {
-        // Use AzerothCore's ObjectAccessor for efficient player lookup
-        return ObjectAccessor::FindPlayerByName(name);
+        { "guid",               PlayerSortKey::Guid },
+        { "name",               PlayerSortKey::Name },
+        { "level",              PlayerSortKey::Level },
+        { "class",              PlayerSortKey::Class },
+        { "race",               PlayerSortKey::Race },
+        { "map_id",             PlayerSortKey::MapId },
+        { "zone_id",            PlayerSortKey::ZoneId },
+        { "honor_points",       PlayerSortKey::HonorPoints },
+        { "arena_points",       PlayerSortKey::ArenaPoints },
+        { "money",              PlayerSortKey::Money },
+        { "average_item_level", PlayerSortKey::AverageItemLevel }
+    };
+
+    static std::string_view GetPlayerSortName(PlayerSortKey key)
+    {
+        for (auto const& [name, sortKey] : PlayerSortNames)
+            if (sortKey == key)
+                return name;
+        return { };
     }
 
-    nlohmann::json GetPlayerSkills(Player* player)
+    // Where a player falls in a sorted listing: its sort value (numeric keys
+    // in Number, the name in Text) and its guid as tie breaker
+    struct PlayerSortPosition
     {
-        nlohmann::json skills = nlohmann::json::object();
+        double Number = 0.0;
+        std::string_view Text;
+        uint32 Guid = 0;
+    };
 
-        if (!player)
-            return skills;
+    static PlayerSortPosition GetPlayerSortPosition(GameStateSnapshot const& snapshot, PlayerSnapshot const& player, PlayerSortKey key)
+    {
+        PlayerSortPosition position;
+        position.Guid = player.Guid.GetCounter();
 
-        // Get castable spells (non-passive spells)
-        nlohmann::json castableSpells = nlohmann::json::array();
+        switch (key)
+        {
+            case PlayerSortKey::Guid:             position.Number = position.Guid; break;
+            case PlayerSortKey::Name:             position.Text = snapshot.GetString(player.NameId); break;
+            case PlayerSortKey::Level:            position.Number = player.Level; break;
+            case PlayerSortKey::Class:            position.Number = player.Class; break;
+            case PlayerSortKey::Race:             position.Number = player.Race; break;
+            case PlayerSortKey::MapId:            position.Number = player.MapId; break;
+            case PlayerSortKey::ZoneId:           position.Number = player.ZoneId; break;
+            case PlayerSortKey::HonorPoints:      position.Number = player.HonorPoints; break;
+            case PlayerSortKey::ArenaPoints:      position.Number = player.ArenaPoints; break;
+            case PlayerSortKey::Money:            position.Number = player.Money; break;
+            case PlayerSortKey::AverageItemLevel: position.Number = player.AverageItemLevel; break;
+        }
 
-        const PlayerSpellMap& spellMap = player->GetSpellMap();
-        // Get castable spells (non-passive spells)
-        for (const auto& spellPair : spellMap)
+        return position;
+    }
+
+    // Strict weak order of the listing: sort value in the requested direction, then guid
+    static bool IsBefore(PlayerListQuery const& query, PlayerSortPosition const& left, PlayerSortPosition const& right)
+    {
+        int32 order = 0;
+        if (query.Sort == PlayerSortKey::Name)
+            order = left.Text.compare(right.Text);
+        else if (left.Number != right.Number)
+            order = left.Number < right.Number ? -1 : 1;
+
+        if (order != 0)
+            return query.Descending ? order > 0 : order < 0;
+
+        return left.Guid < right.Guid;
+    }
+
+    static bool MatchesPlayerList(PlayerListQuery const& query, PlayerSnapshot const& player)
+    {
+        return (!query.MapId || player.MapId == *query.MapId) &&
+            (!query.ZoneId || player.ZoneId == *query.ZoneId) &&
+            (!query.GuildId || (player.HasGuild && player.GuildId == *query.GuildId)) &&
+            (!query.GroupId || (player.HasGroup && player.GroupId == *query.GroupId)) &&
+            (!query.Class || player.Class == *query.Class) &&
+            (!query.Race || player.Race == *query.Race) &&
+            player.Level >= query.LevelMin && player.Level <= query.LevelMax;
+    }
+
+    // Cursors are "<sort>:<a|d>:<guid>:<value>" hex encoded, so clients treat them as opaque
+    static std::string EncodePlayerCursor(PlayerListQuery const& query, PlayerSortPosition const& position)
+    {
+        std::string cursor;
+        cursor.append(GetPlayerSortName(query.Sort)).append(query.Descending ? ":d:" : ":a:").append(std::to_string(position.Guid)).append(":");
+        if (query.Sort == PlayerSortKey::Name)
+            cursor.append(position.Text);
+        else
         {
-            uint32 spellId = spellPair.first;
-            const PlayerSpell* playerSpell = spellPair.second;
+            // Shortest representation that parses back to exactly the same double
+            char buffer[32];
+            std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), position.Number);
+            cursor.append(buffer, result.ptr);
+        }
 
-            // Skip only removed spells
-            if (playerSpell->State == PLAYERSPELL_REMOVED)
-                continue;
+        static constexpr char HexDigits[] = "0123456789abcdef";
+        std::string encoded;
+        encoded.reserve(cursor.size() * 2);
+        for (unsigned char c : cursor)
+        {
+            encoded.push_back(HexDigits[c >> 4]);
+            encoded.push_back(HexDigits[c & 0xF]);
+        }
 
-            // Get spell info
-            SpellInfo const* spellInfo = sSpellMgr->GetSpellInfo(spellId);
-            if (!spellInfo)
-                continue;
+        return encoded;
+    }
 
-            // Skip passive spells - we only want castable abilities
-            if (spellInfo->IsPassive())
+    bool ParsePlayerSort(std::string_view text, PlayerListQuery& query)
+    {
+        query.Descending = !text.empty() && text.front() == '-';
+        if (query.Descending)
+            text.remove_prefix(1);
+
+        for (auto const& [name, key] : PlayerSortNames)
+        {
+            if (name == text)
+            {
+                query.Sort = key;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool ParsePlayerCursor(std::string_view text, PlayerListQuery& query)
+    {
+        if (text.empty() || text.size() % 2)
+            return false;
+
+        std::string cursor;
+        cursor.reserve(text.size() / 2);
+        for (std::size_t i = 0; i < text.size(); i += 2)
+        {
+            uint8 byte = 0;
+            std::from_chars_result result = std::from_chars(text.data() + i, text.data() + i + 2, byte, 16);
+            if (result.ec != std::errc() || result.ptr != text.data() + i + 2)
+                return false;
+            cursor.push_back(static_cast<char>(byte));
+        }
+
+        // The page boundary only means something for the order it was issued for
+        std::string prefix = std::string(GetPlayerSortName(query.Sort)) + (query.Descending ? ":d:" : ":a:");
+        if (cursor.compare(0, prefix.size(), prefix) != 0)
+            return false;
+
+        std::string_view rest = std::string_view(cursor).substr(prefix.size());
+        std::size_t separator = rest.find(':');
+        if (separator == std::string_view::npos)
+            return false;
+
+        std::from_chars_result guid = std::from_chars(rest.data(), rest.data() + separator, query.CursorGuid);
+        if (guid.ec != std::errc() || guid.ptr != rest.data() + separator)
+            return false;
+
+        std::string_view value = rest.substr(separator + 1);
+        if (query.Sort == PlayerSortKey::Name)
+            query.CursorText = std::string(value);
+        else
+        {
+            std::from_chars_result number = std::from_chars(value.data(), value.data() + value.size(), query.CursorNumber);
+            if (number.ec != std::errc() || number.ptr != value.data() + value.size())
+                return false;
+        }
+
+        query.HasCursor = true;
+        return true;
+    }
+
+    void WritePlayerList(GameStateJsonWriter& writer, GameStateSnapshot const& snapshot, PlayerListQuery const& query, uint32 fields)
+    {
+        PlayerSortPosition cursor;
+        cursor.Number = query.CursorNumber;
+        cursor.Text = query.CursorText;
+        cursor.Guid = query.CursorGuid;
+
+        // Start from the smallest index bucket any of the filters selects,
+        // the remaining filters are checked per player
+        std::pair<std::optional<uint32> const*, PlayerIndexType> const indexed[] =
+        {
+            { &query.MapId,   PLAYER_INDEX_MAP },
+            { &query.ZoneId,  PLAYER_INDEX_ZONE },
+            { &query.GuildId, PLAYER_INDEX_GUILD },
+            { &query.GroupId, PLAYER_INDEX_GROUP }
+        };
+
+        static PlayerIndexList const NoPlayers;
+        PlayerIndexList const* candidates = nullptr;
+        for (auto const& [key, index] : indexed)
+        {
+            if (!*key)
                 continue;
 
-            nlohmann::json spellData = {
-                {"spell_id", spellId},
-                {"name", spellInfo->SpellName[0] ? spellInfo->SpellName[0] : "Unknown"},
-                {"rank", spellInfo->Rank[0] ? spellInfo->Rank[0] : ""},
-                {"school", spellInfo->SchoolMask},
-                {"cast_time", spellInfo->CastTimeEntry ? spellInfo->CastTimeEntry->CastTime : 0},
-                {"cooldown", spellInfo->RecoveryTime},
-                {"range", spellInfo->RangeEntry ? spellInfo->RangeEntry->RangeMax[0] : 0.0f}
-            };
+            PlayerIndexList const* bucket = snapshot.FindPlayers(index, **key);
+            if (!bucket)
+                bucket = &NoPlayers;
+            if (!candidates || bucket->size() < candidates->size())
+                candidates = bucket;
+        }
+
+        // Keyset pagination: a page starts right after the last player of the
+        // previous one, so it stays stable while players come and go
+        std::size_t total = 0;
+        std::vector<std::pair<PlayerSortPosition, PlayerSnapshot const*>> matches;
+        auto visit = [&](PlayerSnapshot const& player)
+        {
+            if (!MatchesPlayerList(query, player))
+                return;
+
+            ++total;
+            PlayerSortPosition position = GetPlayerSortPosition(snapshot, player, query.Sort);
+            if (!query.HasCursor || IsBefore(query, cursor, position))
+                matches.emplace_back(position, &player);
+        };
+
+        if (candidates)
+        {
+            for (uint32 index : *candidates)
+                visit(snapshot.Players[index]);
+        }
+        else
+        {
+            for (PlayerSnapshot const& player : snapshot.Players)
+                visit(player);
+        }
+
+        auto before = [&query](std::pair<PlayerSortPosition, PlayerSnapshot const*> const& left, std::pair<PlayerSortPosition, PlayerSnapshot const*> const& right)
+        {
+            return IsBefore(query, left.first, right.first);
+        };
 
-            castableSpells.push_back(spellData);
+        // Players are kept sorted by guid already, anything else only needs the page sorted
+        bool more = query.Limit && matches.size() > query.Limit;
+        if (more)
+        {
+            if (query.Sort == PlayerSortKey::Guid && !query.Descending)
+                matches.resize(query.Limit);
+            else
+            {
+                std::partial_sort(matches.begin(), matches.begin() + query.Limit, matches.end(), before);
+                matches.resize(query.Limit);
+            }
         }
+        else if (query.Sort != PlayerSortKey::Guid || query.Descending)
+            std::sort(matches.begin(), matches.end(), before);
+
+        writer.BeginObject();
+        writer.Field("count", matches.size());
+        if (more)
+            writer.Field("next_cursor", EncodePlayerCursor(query, matches.back().first));
+
+        writer.Key("players");
+        writer.BeginArray();
+        for (auto const& [position, player] : matches)
+            WritePlayerData(writer, snapshot, *player, fields);
+        writer.EndArray();
+
+        writer.Field("total", total);
+        writer.EndObject();
+    }
 
-        skills["castable_spells"] = castableSpells;
-        skills["spell_count"] = castableSpells.size();
+    void WriteSelectedPlayers(GameStateJsonWriter& writer, GameStateSnapshot const& snapshot, std::vector<std::string> const& names,
+        std::vector<uint32> const& guids, uint32 fields)
+    {
+        std::vector<PlayerSnapshot const*> found;
+        std::vector<std::string_view> missingNames;
+        std::vector<uint32> missingGuids;
 
-        return skills;
+        for (std::string const& name : names)
+        {
+            if (PlayerSnapshot const* player = snapshot.FindPlayer(name))
+                found.push_back(player);
+            else
+                missingNames.push_back(name);
+        }
+
+        for (uint32 guid : guids)
+        {
+            if (PlayerSnapshot const* player = snapshot.FindPlayerByGuid(guid))
+                found.push_back(player);
+            else
+                missingGuids.push_back(guid);
+        }
+
+        writer.BeginObject();
+        writer.Field("count", found.size());
+        writer.Key("missing");
+        writer.BeginObject();
+        writer.Key("guids");
+        writer.BeginArray();
+        for (uint32 guid : missingGuids)
+            writer.Value(guid);
+        writer.EndArray();
+        writer.Key("names");
+        writer.BeginArray();
+        for (std::string_view name : missingNames)
+            writer.Value(name);
+        writer.EndArray();
+        writer.EndObject();
+
+        writer.Key("players");
+        writer.BeginArray();
+        for (PlayerSnapshot const* player : found)
+            WritePlayerData(writer, snapshot, *player, fields);
+        writer.EndArray();
+        writer.EndObject();
     }
 
-    nlohmann::json GetPlayerSkillsFull(Player* player)
+    void WritePlayerPositions(GameStateJsonWriter& writer, GameStateSnapshot const& snapshot, uint32 mapId, PlayerMapArea const& area)
     {
-        nlohmann::json skills = nlohmann::json::object();
+        std::vector<uint32> found;
+        if (area.Whole)
+        {
+            if (PlayerIndexList const* players = snapshot.FindPlayers(PLAYER_INDEX_MAP, mapId))
+                found = *players;
+        }
+        else if (PlayerPositionGrid const* grid = snapshot.FindPositionGrid(mapId))
+        {
+            float centerX = (area.MinX + area.MaxX) / 2;
+            float centerY = (area.MinY + area.MaxY) / 2;
 
-        if (!player)
-            return skills;
+            // Cells only narrow it down, the exact test is per player
+            grid->ForEachInBox(area.MinX, area.MinY, area.MaxX, area.MaxY, [&](uint32 index)
+            {
+                PlayerSnapshot const& player = snapshot.Players[index];
+                if (player.PositionX < area.MinX || player.PositionX > area.MaxX || player.PositionY < area.MinY || player.PositionY > area.MaxY)
+                    return;
 
-        // Get all learned skills (the original implementation)
-        nlohmann::json skillsArray = nlohmann::json::array();
+                if (area.Radius)
+                {
+                    float dx = player.PositionX - centerX;
+                    float dy = player.PositionY - centerY;
+                    if (dx * dx + dy * dy > *area.Radius * *area.Radius)
+                        return;
+                }
+
+                found.push_back(index);
+            });
+
+            std::sort(found.begin(), found.end());
+        }
+
+        writer.BeginObject();
+        writer.Field("count", found.size());
+        writer.Field("map_id", mapId);
+        writer.Key("players");
+        writer.BeginArray();
+        for (uint32 index : found)
+        {
+            PlayerSnapshot const& player = snapshot.Players[index];
+            writer.BeginObject();
+            writer.Field("guid", player.Guid.GetCounter());
+            writer.Field("name", snapshot.GetString(player.NameId));
+            writer.Field("orientation", player.Orientation);
+            writer.Field("x", player.PositionX);
+            writer.Field("y", player.PositionY);
+            writer.Field("z", player.PositionZ);
+            writer.Field("zone_id", player.ZoneId);
+            writer.EndObject();
+        }
+        writer.EndArray();
+        writer.EndObject();
+    }
+
+    Player* FindPlayerByName(const std::string& name)
+    {
+        // Use AzerothCore's ObjectAccessor for efficient player lookup
+        return ObjectAccessor::FindPlayerByName(name);
+    }
+
+    PlayerSkillsSnapshot GetPlayerSkillsSnapshot(Player* player)
+    {
+        PlayerSkillsSnapshot skills;
+
+        // Known spells; SpellInfo is static and is resolved while serializing
+        const PlayerSpellMap& spellMap = player->GetSpellMap();
+        skills.Spells.reserve(spellMap.size());
+        for (const auto& spellPair : spellMap)
+        {
+            // Skip only removed spells
+            if (spellPair.second->State == PLAYERSPELL_REMOVED)
+                continue;
+
+            skills.Spells.push_back(spellPair.first);
+        }
 
         // Iterate through all skill lines that the player has
         for (uint32 i = 0; i < PLAYER_MAX_SKILLS; ++i)
@@ -573,147 +1205,426 @@ namespace GameStateUtilities
                 continue;
 
             uint16 skillId = SKILL_VALUE(skill);
-            uint16 skillStep = SKILL_MAX(skill);
-
             if (skillId == 0)
                 continue;
 
-            // Get skill values
-            uint16 skillValue = player->GetSkillValue(skillId);
-            uint16 maxSkillValue = player->GetMaxSkillValue(skillId);
-            uint16 pureSkillValue = player->GetPureSkillValue(skillId);
-            int16 permBonus = player->GetSkillPermBonusValue(skillId);
-            int16 tempBonus = player->GetSkillTempBonusValue(skillId);
-
-            nlohmann::json skillData = {
-                {"skill_id", skillId},
-                {"skill_step", skillStep},
-                {"current_value", skillValue},
-                {"max_value", maxSkillValue},
-                {"pure_value", pureSkillValue},
-                {"permanent_bonus", permBonus},
-                {"temporary_bonus", tempBonus}
-            };
+            SkillLineSnapshot& skillLine = skills.SkillLines.emplace_back();
+            skillLine.SkillId = skillId;
+            skillLine.SkillStep = SKILL_MAX(skill);
+            skillLine.Value = player->GetSkillValue(skillId);
+            skillLine.MaxValue = player->GetMaxSkillValue(skillId);
+            skillLine.PureValue = player->GetPureSkillValue(skillId);
+            skillLine.PermanentBonus = player->GetSkillPermBonusValue(skillId);
+            skillLine.TemporaryBonus = player->GetSkillTempBonusValue(skillId);
+        }
 
-            // Add skill line name if available
-            if (SkillLineEntry const* skillLineEntry = sSkillLineStore.LookupEntry(skillId))
+        // Get talent points spent in each tree
+        // Note: This is a simplified version, full talent tree data would require more complex implementation
+        skills.ActiveSpec = player->GetActiveSpec();
+        skills.SpecsCount = player->GetSpecsCount();
+        skills.TotalTalentPoints = player->CalculateTalentsPoints();
+        skills.FreeTalentPoints = player->GetFreeTalentPoints();
+        skills.UsedTalentPoints = (skills.TotalTalentPoints >= skills.FreeTalentPoints) ? (skills.TotalTalentPoints - skills.FreeTalentPoints) : 0;
+
+        return skills;
+    }
+
+    void WritePlayerTalentInfo(GameStateJsonWriter& writer, PlayerSkillsSnapshot const& skills)
+    {
+        writer.BeginObject();
+        writer.Field("active_spec", skills.ActiveSpec);
+        writer.Field("specs_count", skills.SpecsCount);
+        writer.Key("talent_points");
+        writer.BeginObject();
+        writer.Field("available", skills.FreeTalentPoints);
+        writer.Field("total", skills.TotalTalentPoints);
+        writer.Field("used", skills.UsedTalentPoints);
+        writer.EndObject();
+        writer.EndObject();
+    }
+
+    static void WriteSpellData(GameStateJsonWriter& writer, SpellInfo const* spellInfo)
+    {
+        writer.BeginObject();
+        writer.Field("cast_time", spellInfo->CastTimeEntry ? spellInfo->CastTimeEntry->CastTime : 0);
+        writer.Field("cooldown", spellInfo->RecoveryTime);
+        writer.Field("name", spellInfo->SpellName[0] ? spellInfo->SpellName[0] : "Unknown");
+        writer.Field("range", spellInfo->RangeEntry ? spellInfo->RangeEntry->RangeMax[0] : 0.0f);
+        writer.Field("rank", spellInfo->Rank[0] ? spellInfo->Rank[0] : "");
+        writer.Field("school", spellInfo->SchoolMask);
+        writer.Field("spell_id", spellInfo->Id);
+        writer.EndObject();
+    }
+
+    static std::unique_ptr<SpellFragment> BuildSpellFragment(uint32 spellId)
+    {
+        SpellInfo const* spellInfo = sSpellMgr->GetSpellInfo(spellId);
+        if (!spellInfo)
+            return nullptr;
+
+        std::unique_ptr<SpellFragment> fragment = std::make_unique<SpellFragment>();
+        fragment->IsPassive = spellInfo->IsPassive();
+
+        // Passive spells are never listed, only their flag is needed
+        if (!fragment->IsPassive)
+        {
+            GameStateJsonWriter writer(fragment->Json);
+            WriteSpellData(writer, spellInfo);
+            fragment->Json.shrink_to_fit();
+        }
+
+        return fragment;
+    }
+
+    // Writes the "castable_spells" array and returns how many entries it got
+    static std::size_t WriteCastableSpells(GameStateJsonWriter& writer, PlayerSkillsSnapshot const& skills)
+    {
+        std::size_t spellCount = 0;
+
+        writer.Key("castable_spells");
+        writer.BeginArray();
+        for (uint32 spellId : skills.Spells)
+        {
+            // Cached fragments are compact, indented output is written directly
+            if (writer.IsCompact())
             {
-                skillData["name"] = skillLineEntry->name[0]; // Default locale
+                if (SpellFragment const* fragment = SpellFragments.Get(spellId, BuildSpellFragment))
+                {
+                    if (!fragment->IsPassive)
+                    {
+                        writer.Raw(fragment->Json);
+                        ++spellCount;
+                    }
+
+                    continue;
+                }
             }
 
-            skillsArray.push_back(skillData);
-        }
+            // Get spell info
+            SpellInfo const* spellInfo = sSpellMgr->GetSpellInfo(spellId);
+            if (!spellInfo)
+                continue;
 
-        skills["passive_skills"] = skillsArray;
+            // Skip passive spells - we only want castable abilities
+            if (spellInfo->IsPassive())
+                continue;
 
-        // Get talent information
-        nlohmann::json talentsInfo = GetPlayerTalentInfo(player);
-        skills["talents"] = talentsInfo;
+            WriteSpellData(writer, spellInfo);
+            ++spellCount;
+        }
+        writer.EndArray();
 
-        // Get castable spells
-        nlohmann::json castableData = GetPlayerSkills(player);
-        skills["castable_spells"] = castableData["castable_spells"];
-        skills["spell_count"] = castableData["spell_count"];
+        return spellCount;
+    }
 
-        return skills;
+    void WritePlayerSkills(GameStateJsonWriter& writer, PlayerSkillsSnapshot const& skills)
+    {
+        writer.BeginObject();
+        std::size_t spellCount = WriteCastableSpells(writer, skills);
+        writer.Field("spell_count", spellCount);
+        writer.EndObject();
     }
 
-    nlohmann::json GetPlayerQuests(Player* player)
+    void WritePlayerSkillsFull(GameStateJsonWriter& writer, PlayerSkillsSnapshot const& skills)
     {
-        nlohmann::json questsData = nlohmann::json::object();
+        writer.BeginObject();
+
+        // Castable spells are written once here instead of building the
+        // /skills document and copying its members over
+        std::size_t spellCount = WriteCastableSpells(writer, skills);
+
+        // Get all learned skills (the original implementation)
+        writer.Key("passive_skills");
+        writer.BeginArray();
+        for (SkillLineSnapshot const& skillLine : skills.SkillLines)
+        {
+            writer.BeginObject();
+            writer.Field("current_value", skillLine.Value);
+            writer.Field("max_value", skillLine.MaxValue);
+
+            // Add skill line name if available
+            if (SkillLineEntry const* skillLineEntry = sSkillLineStore.LookupEntry(skillLine.SkillId))
+            {
+                writer.Field("name", skillLineEntry->name[0]); // Default locale
+            }
+
+            writer.Field("permanent_bonus", skillLine.PermanentBonus);
+            writer.Field("pure_value", skillLine.PureValue);
+            writer.Field("skill_id", skillLine.SkillId);
+            writer.Field("skill_step", skillLine.SkillStep);
+            writer.Field("temporary_bonus", skillLine.TemporaryBonus);
+            writer.EndObject();
+        }
+        writer.EndArray();
+
+        writer.Field("spell_count", spellCount);
 
-        if (!player)
-            return questsData;
+        // Get talent information
+        writer.Key("talents");
+        WritePlayerTalentInfo(writer, skills);
+
+        writer.EndObject();
+    }
 
-        nlohmann::json activeQuests = nlohmann::json::array();
-        nlohmann::json completedQuests = nlohmann::json::array();
+    PlayerQuestsSnapshot GetPlayerQuestsSnapshot(Player* player)
+    {
+        PlayerQuestsSnapshot quests;
 
         // Get quest status map
         QuestStatusMap& questStatusMap = player->getQuestStatusMap();
+        quests.reserve(questStatusMap.size());
 
         for (const auto& questStatusPair : questStatusMap)
         {
-            uint32 questId = questStatusPair.first;
-            const QuestStatusData& questStatus = questStatusPair.second;
+            QuestStatusSnapshot& quest = quests.emplace_back();
+            quest.QuestId = questStatusPair.first;
+            quest.Status = questStatusPair.second;
+        }
 
-            // Get quest template
-            Quest const* quest = sObjectMgr->GetQuestTemplate(questId);
-            if (!quest)
-                continue;
+        return quests;
+    }
 
-            nlohmann::json questData = {
-                {"quest_id", questId},
-                {"title", quest->GetTitle()},
-                {"description", quest->GetDetails()},
-                {"level", quest->GetQuestLevel()},
-                {"min_level", quest->GetMinLevel()},
-                {"quest_type", quest->GetType()},
-                {"suggested_players", quest->GetSuggestedPlayers()},
-                {"time_limit", quest->GetTimeAllowed()},
-                {"is_daily", quest->IsDaily()},
-                {"is_weekly", quest->IsWeekly()},
-                {"is_repeatable", quest->IsRepeatable()},
-                {"status", static_cast<uint32>(questStatus.Status)}
-            };
-
-            // Add quest objectives progress if quest is in progress
-            if (questStatus.Status == QUEST_STATUS_INCOMPLETE)
-            {
-                nlohmann::json objectives = nlohmann::json::array();
+    static bool IsActiveQuest(QuestStatus status)
+    {
+        return status == QUEST_STATUS_INCOMPLETE || status == QUEST_STATUS_COMPLETE;
+    }
 
-                // Item objectives
-                nlohmann::json itemObjectives = nlohmann::json::array();
-                for (uint32 i = 0; i < QUEST_ITEM_OBJECTIVES_COUNT; ++i)
-                {
-                    if (quest->RequiredItemId[i] > 0)
-                    {
-                        itemObjectives.push_back({
-                            {"item_id", quest->RequiredItemId[i]},
-                            {"required_count", quest->RequiredItemCount[i]},
-                            {"current_count", questStatus.ItemCount[i]}
-                        });
-                    }
-                }
+    // Members of the quest object that only depend on the template, split at
+    // the per-player fields so they can be cached
+    static void WriteQuestDescription(GameStateJsonWriter& writer, Quest const* quest)
+    {
+        writer.Field("description", quest->GetDetails());
+    }
 
-                // Creature/GameObject objectives
-                nlohmann::json creatureObjectives = nlohmann::json::array();
-                for (uint32 i = 0; i < QUEST_OBJECTIVES_COUNT; ++i)
-                {
-                    if (quest->RequiredNpcOrGo[i] != 0)
-                    {
-                        creatureObjectives.push_back({
-                            {"npc_or_go_id", quest->RequiredNpcOrGo[i]},
-                            {"required_count", quest->RequiredNpcOrGoCount[i]},
-                            {"current_count", questStatus.CreatureOrGOCount[i]}
-                        });
-                    }
-                }
+    static void WriteQuestFlags(GameStateJsonWriter& writer, Quest const* quest)
+    {
+        writer.Field("is_daily", quest->IsDaily());
+        writer.Field("is_repeatable", quest->IsRepeatable());
+        writer.Field("is_weekly", quest->IsWeekly());
+    }
 
-                questData["item_objectives"] = itemObjectives;
-                questData["creature_objectives"] = creatureObjectives;
-                questData["explored"] = questStatus.Explored;
-                questData["timer"] = questStatus.Timer;
+    static void WriteQuestInfo(GameStateJsonWriter& writer, Quest const* quest)
+    {
+        writer.Field("level", quest->GetQuestLevel());
+        writer.Field("min_level", quest->GetMinLevel());
+        writer.Field("quest_id", quest->GetQuestId());
+        writer.Field("quest_type", quest->GetType());
+    }
 
-                activeQuests.push_back(questData);
-            }
-            else if (questStatus.Status == QUEST_STATUS_COMPLETE)
+    static void WriteQuestLimits(GameStateJsonWriter& writer, Quest const* quest)
+    {
+        writer.Field("suggested_players", quest->GetSuggestedPlayers());
+        writer.Field("time_limit", quest->GetTimeAllowed());
+    }
+
+    static void WriteQuestTitle(GameStateJsonWriter& writer, Quest const* quest)
+    {
+        writer.Field("title", quest->GetTitle());
+    }
+
+    static std::unique_ptr<QuestFragment> BuildQuestFragment(Quest const* quest)
+    {
+        return QuestFragment::Build(
+            [quest](GameStateJsonWriter& writer) { WriteQuestDescription(writer, quest); },
+            [quest](GameStateJsonWriter& writer) { WriteQuestFlags(writer, quest); },
+            [quest](GameStateJsonWriter& writer) { WriteQuestInfo(writer, quest); },
+            [quest](GameStateJsonWriter& writer) { WriteQuestLimits(writer, quest); },
+            [quest](GameStateJsonWriter& writer) { WriteQuestTitle(writer, quest); });
+    }
+
+    static void WriteQuestData(GameStateJsonWriter& writer, Quest const* quest, QuestStatusSnapshot const& questStatus)
+    {
+        QuestStatusData const& status = questStatus.Status;
+
+        // Quest objectives progress is only reported while the quest is in progress
+        bool inProgress = status.Status == QUEST_STATUS_INCOMPLETE;
+
+        // Cached fragments are compact, indented output is written directly
+        QuestFragment const* fragment = nullptr;
+        if (writer.IsCompact())
+            fragment = QuestFragments.Get(questStatus.QuestId, [quest](uint32 /*questId*/) { return BuildQuestFragment(quest); });
+
+        auto writeTemplate = [&](std::size_t segment, void (*write)(GameStateJsonWriter&, Quest const*))
+        {
+            if (fragment)
+                writer.Raw(fragment->Get(segment));
+            else
+                write(writer, quest);
+        };
+
+        writer.BeginObject();
+
+        if (inProgress)
+        {
+            // Creature/GameObject objectives
+            writer.Key("creature_objectives");
+            writer.BeginArray();
+            for (uint32 i = 0; i < QUEST_OBJECTIVES_COUNT; ++i)
             {
-                // Quest is complete but not yet turned in
-                questData["ready_to_turn_in"] = true;
-                activeQuests.push_back(questData);
+                if (quest->RequiredNpcOrGo[i] != 0)
+                {
+                    writer.BeginObject();
+                    writer.Field("current_count", status.CreatureOrGOCount[i]);
+                    writer.Field("npc_or_go_id", quest->RequiredNpcOrGo[i]);
+                    writer.Field("required_count", quest->RequiredNpcOrGoCount[i]);
+                    writer.EndObject();
+                }
             }
-            else if (questStatus.Status == QUEST_STATUS_REWARDED)
+            writer.EndArray();
+        }
+
+        writeTemplate(0, WriteQuestDescription);
+
+        if (inProgress)
+        {
+            writer.Field("explored", status.Explored);
+        }
+
+        writeTemplate(1, WriteQuestFlags);
+
+        if (inProgress)
+        {
+            // Item objectives
+            writer.Key("item_objectives");
+            writer.BeginArray();
+            for (uint32 i = 0; i < QUEST_ITEM_OBJECTIVES_COUNT; ++i)
             {
-                // Quest has been completed and turned in
-                completedQuests.push_back(questData);
+                if (quest->RequiredItemId[i] > 0)
+                {
+                    writer.BeginObject();
+                    writer.Field("current_count", status.ItemCount[i]);
+                    writer.Field("item_id", quest->RequiredItemId[i]);
+                    writer.Field("required_count", quest->RequiredItemCount[i]);
+                    writer.EndObject();
+                }
             }
+            writer.EndArray();
+        }
+
+        writeTemplate(2, WriteQuestInfo);
+
+        if (status.Status == QUEST_STATUS_COMPLETE)
+        {
+            // Quest is complete but not yet turned in
+            writer.Field("ready_to_turn_in", true);
+        }
+
+        writer.Field("status", static_cast<uint32>(status.Status));
+
+        writeTemplate(3, WriteQuestLimits);
+
+        if (inProgress)
+        {
+            writer.Field("timer", status.Timer);
         }
 
-        questsData["active_quests"] = activeQuests;
-        questsData["completed_quests"] = completedQuests;
-        questsData["active_count"] = activeQuests.size();
-        questsData["completed_count"] = completedQuests.size();
+        writeTemplate(4, WriteQuestTitle);
 
-        return questsData;
+        writer.EndObject();
     }
+
+    void WritePlayerQuests(GameStateJsonWriter& writer, PlayerQuestsSnapshot const& quests)
+    {
+        // Resolve templates once; the counts are written ahead of the arrays
+        std::vector<std::pair<Quest const*, QuestStatusSnapshot const*>> activeQuests;
+        std::vector<std::pair<Quest const*, QuestStatusSnapshot const*>> completedQuests;
+
+        for (QuestStatusSnapshot const& questStatus : quests)
+        {
+            QuestStatus status = questStatus.Status.Status;
+            if (!IsActiveQuest(status) && status != QUEST_STATUS_REWARDED)
+                continue;
+
+            // Get quest template
+            Quest const* quest = sObjectMgr->GetQuestTemplate(questStatus.QuestId);
+            if (!quest)
+                continue;
+
+            if (IsActiveQuest(status))
+                activeQuests.emplace_back(quest, &questStatus);
+            else
+                completedQuests.emplace_back(quest, &questStatus);
+        }
+
+        writer.BeginObject();
+
+        writer.Field("active_count", activeQuests.size());
+        writer.Key("active_quests");
+        writer.BeginArray();
+        for (const auto& [quest, questStatus] : activeQuests)
+        {
+            WriteQuestData(writer, quest, *questStatus);
+        }
+        writer.EndArray();
+
+        writer.Field("completed_count", completedQuests.size());
+        writer.Key("completed_quests");
+        writer.BeginArray();
+        for (const auto& [quest, questStatus] : completedQuests)
+        {
+            WriteQuestData(writer, quest, *questStatus);
+        }
+        writer.EndArray();
+
+        writer.EndObject();
+    }
+}
+
+uint32 PlayerListQuery::GetRequiredFields() const
+{
+    uint32 fields = 0;
+    if (GuildId)
+        fields |= PLAYER_FIELD_GUILD;
+    if (GroupId)
+        fields |= PLAYER_FIELD_GROUP;
+    if (Sort == PlayerSortKey::AverageItemLevel)
+        fields |= PLAYER_FIELD_STATS;
+    return fields;
+}
+
+std::string PlayerListQuery::GetKey() const
+{
+    auto optional = [](std::optional<uint32> const& value) { return value ? std::to_string(*value) : std::string(); };
+
+    std::string key = "map=" + optional(MapId) + "&zone=" + optional(ZoneId) + "&guild=" + optional(GuildId) + "&group=" + optional(GroupId) +
+        "&class=" + optional(Class) + "&race=" + optional(Race) +
+        "&level=" + std::to_string(LevelMin) + "-" + std::to_string(LevelMax) +
+        "&sort=" + std::to_string(static_cast<uint32>(Sort)) + (Descending ? "d" : "a") +
+        "&limit=" + std::to_string(Limit);
+
+    if (HasCursor)
+    {
+        // Shortest exact number, as in the cursor itself, and the text last
+        // behind its length, so no two cursors share a key
+        char buffer[32];
+        std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), CursorNumber);
+        key.append("&after=").append(std::to_string(CursorGuid)).append(":").append(buffer, result.ptr)
+            .append(":").append(std::to_string(CursorText.size())).append(":").append(CursorText);
+    }
+
+    return key;
+}
+
+std::string PlayerMapArea::GetKey() const
+{
+    if (Whole)
+        return "all";
+
+    // Shortest exact form, areas that differ in any digit must not share a key
+    std::string key;
+    auto append = [&key](float value)
+    {
+        char buffer[32];
+        std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        key.append(key.empty() ? "" : ",").append(buffer, result.ptr);
+    };
+
+    append(MinX);
+    append(MinY);
+    append(MaxX);
+    append(MaxY);
+    if (Radius)
+        append(*Radius);
+
+    return key;
 }
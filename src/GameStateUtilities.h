@@ -5,45 +5,167 @@
 #ifndef GAMESTATEAPI_GAMESTATESUTILITIES_H
 #define GAMESTATEAPI_GAMESTATESUTILITIES_H
 
+#include "GameStateJsonWriter.h"
+#include "GameStateSnapshot.h"
 #include <nlohmann/json.hpp>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
 
 class Player;
 class Item;
 
+// Orders /api/players can be sorted by; ties are always broken by guid
+enum class PlayerSortKey : uint8
+{
+    Guid,
+    Name,
+    Level,
+    Class,
+    Race,
+    MapId,
+    ZoneId,
+    HonorPoints,
+    ArenaPoints,
+    Money,
+    AverageItemLevel
+};
+
+// Filters, order and page of a /api/players listing
+struct PlayerListQuery
+{
+    std::optional<uint32> MapId;
+    std::optional<uint32> ZoneId;
+    std::optional<uint32> GuildId;
+    std::optional<uint32> GroupId;
+    std::optional<uint32> Class;
+    std::optional<uint32> Race;
+    uint32 LevelMin = 0;
+    uint32 LevelMax = std::numeric_limits<uint32>::max();
+
+    PlayerSortKey Sort = PlayerSortKey::Guid;
+    bool Descending = false;
+    uint32 Limit = 0; // 0 returns every match
+
+    // Position of the last player of the previous page, decoded from the cursor
+    bool HasCursor = false;
+    double CursorNumber = 0.0;
+    std::string CursorText;
+    uint32 CursorGuid = 0;
+
+    // PlayerFieldFlags the snapshot must have captured to evaluate the query
+    uint32 GetRequiredFields() const;
+
+    // Canonical form, used as response cache key
+    std::string GetKey() const;
+};
+
+// Part of a map selected by /api/map/{id}/players: the whole map, a box
+// or, when Radius is set, the circle around the box's centre
+struct PlayerMapArea
+{
+    bool Whole = true;
+    float MinX = 0.0f;
+    float MinY = 0.0f;
+    float MaxX = 0.0f;
+    float MaxY = 0.0f;
+    std::optional<float> Radius;
+
+    // Canonical form, used as response cache key
+    std::string GetKey() const;
+};
+
+// Get*Snapshot functions read the live Player and must run on the world thread.
+// Write* functions only touch snapshots and static templates and can run on
+// any thread.
 namespace GameStateUtilities
 {
-    // Get detailed item information as JSON
-    nlohmann::json GetItemData(Item* item);
+    // Size the pre-serialized template caches; call before the HTTP server starts
+    void InitializeTemplateCaches();
+
+    // Release the template caches; call after the HTTP server stopped
+    void ClearTemplateCaches();
+
+    // Copy the per-instance fields of an item (entry, count, durability)
+    ItemSnapshot GetItemSnapshot(Item* item);
 
-    // Get player equipment information as JSON (with detailed item stats)
-    nlohmann::json GetPlayerEquipment(Player* player);
+    // Write detailed item information from a snapshotted item
+    void WriteItemData(GameStateJsonWriter& writer, ItemSnapshot const& item);
 
-    // Get player statistics (health, mana, stats, resistances, etc.)
-    nlohmann::json GetPlayerStats(Player* player);
+    // Write player equipment (with detailed item stats) from snapshotted equipment slots
+    void WritePlayerEquipment(GameStateJsonWriter& writer, std::array<ItemSnapshot, GAME_STATE_EQUIPMENT_SLOTS> const& items);
 
-    // Get comprehensive player data as JSON
-    nlohmann::json GetPlayerData(Player* player, bool includeEquipment = false);
+    // Capture player statistics (health, mana, stats, resistances, etc.)
+    PlayerStatsSnapshot GetPlayerStatsSnapshot(Player* player);
 
-    // Get server state information as JSON
-    nlohmann::json GetServerData();
+    // Write player statistics
+    void WritePlayerStats(GameStateJsonWriter& writer, PlayerStatsSnapshot const& stats);
 
-    // Get all online players data as JSON array
-    nlohmann::json GetAllPlayersData(bool includeEquipment = false);
+    // Write comprehensive player data from a snapshotted player, limited to
+    // the PlayerFieldFlags in fields (which the snapshot must have captured)
+    void WritePlayerData(GameStateJsonWriter& writer, GameStateSnapshot const& snapshot, PlayerSnapshot const& player, uint32 fields = PLAYER_FIELDS_DEFAULT);
+
+    // Parse a comma separated ?fields= list into PlayerFieldFlags; false if
+    // the list is empty or names an unknown field
+    bool ParsePlayerFields(std::string_view list, uint32& fields);
+
+    // Write server state information
+    void WriteServerData(GameStateJsonWriter& writer, ServerSnapshot const& server);
+
+    // Write all snapshotted players as a JSON array
+    void WriteAllPlayersData(GameStateJsonWriter& writer, GameStateSnapshot const& snapshot, uint32 fields = PLAYER_FIELDS_DEFAULT);
+
+    // Write every snapshotted player as the starting point of an incremental sync
+    void WritePlayersFull(GameStateJsonWriter& writer, GameStateSnapshot const& snapshot, uint32 fields = PLAYER_FIELDS_DEFAULT);
+
+    // Write the players added, changed and removed after version since, which
+    // must satisfy snapshot.CanDiffFrom(since). Returns the number of entries.
+    std::size_t WritePlayersDelta(GameStateJsonWriter& writer, GameStateSnapshot const& snapshot, uint64 since, uint32 fields = PLAYER_FIELDS_DEFAULT);
+
+    // Parse sort=, a sort key name optionally prefixed with '-' for descending order
+    bool ParsePlayerSort(std::string_view text, PlayerListQuery& query);
+
+    // Decode cursor= into query, which must already have its sort set; false
+    // for a malformed cursor or one issued for a different order
+    bool ParsePlayerCursor(std::string_view text, PlayerListQuery& query);
+
+    // Write the players matching query as {"count","next_cursor","players","total"}.
+    // Map, zone, guild and group filters only visit the players in the
+    // smallest matching index bucket. Only the requested page is sorted, with
+    // a partial sort when it is a top-k.
+    void WritePlayerList(GameStateJsonWriter& writer, GameStateSnapshot const& snapshot, PlayerListQuery const& query, uint32 fields = PLAYER_FIELDS_DEFAULT);
+
+    // Write the named players and those with the given guid counters, in the
+    // order asked for, as {"count","missing":{"guids","names"},"players"}
+    void WriteSelectedPlayers(GameStateJsonWriter& writer, GameStateSnapshot const& snapshot, std::vector<std::string> const& names,
+        std::vector<uint32> const& guids, uint32 fields = PLAYER_FIELDS_DEFAULT);
+
+    // Write the players of mapId within area as compact position records
+    // {"guid","name","orientation","x","y","z","zone_id"}, in guid order
+    void WritePlayerPositions(GameStateJsonWriter& writer, GameStateSnapshot const& snapshot, uint32 mapId, PlayerMapArea const& area);
 
     // Find a player by name
     Player* FindPlayerByName(const std::string& name);
 
-    // Get player's talent specialization info
-    nlohmann::json GetPlayerTalentInfo(Player* player);
+    // Capture player's spells, skill lines and talent points
+    PlayerSkillsSnapshot GetPlayerSkillsSnapshot(Player* player);
+
+    // Write player's talent specialization info
+    void WritePlayerTalentInfo(GameStateJsonWriter& writer, PlayerSkillsSnapshot const& skills);
+
+    // Write player's castable spells
+    void WritePlayerSkills(GameStateJsonWriter& writer, PlayerSkillsSnapshot const& skills);
 
-    // Get player's skills and talents information
-    nlohmann::json GetPlayerSkills(Player* player);
+    // Write player's full skills and talents information (includes passive skills)
+    void WritePlayerSkillsFull(GameStateJsonWriter& writer, PlayerSkillsSnapshot const& skills);
 
-    // Get player's full skills and talents information (includes passive skills)
-    nlohmann::json GetPlayerSkillsFull(Player* player);
+    // Capture player's quest status map
+    PlayerQuestsSnapshot GetPlayerQuestsSnapshot(Player* player);
 
-    // Get player's active quests information
-    nlohmann::json GetPlayerQuests(Player* player);
+    // Write player's active and completed quests
+    void WritePlayerQuests(GameStateJsonWriter& writer, PlayerQuestsSnapshot const& quests);
 }
 
 #endif // GAMESTATEAPI_GAMESTATESUTILITIES_H
@@ -4,127 +4,380 @@
 
 #include "HttpGameStateServer.h"
 #include "GameStateAPI.h"
+#include "GameStateCompression.h"
+#include "GameStateEpollServer.h"
+#include "GameStateFormat.h"
+#include "GameStateRequestLanes.h"
+#include "GameStateRouter.h"
+#include "GameStateSnapshot.h"
+#include "GameStateStream.h"
+#include "GameStateTaskQueue.h"
 #include "GameStateUtilities.h"
 #include "Log.h"
-#include "ObjectAccessor.h"
-#include "Player.h"
-#include "WorldSession.h"
-#include "WorldSessionMgr.h"
-#include "World.h"
-#include "GameTime.h"
 #include <nlohmann/json.hpp>
+#include <charconv>
+#include <cmath>
+#include <limits>
 
 using json = nlohmann::json;
 
-HttpGameStateServer::HttpGameStateServer(const std::string& host, uint16 port, const std::string& allowedOrigin)
+// How long an HTTP thread waits for the world thread to answer a player query
+static constexpr std::chrono::seconds WORLD_QUERY_TIMEOUT(5);
+
+// Set while the epoll backend dispatches a request: /api/stream hands its
+// stream over through it instead of installing a content provider
+static thread_local std::shared_ptr<GameStateStream>* ReactorStream = nullptr;
+
+// Lanes of the listener whose worker this is. Every worker serves a single
+// listener; it is set before the handlers of each request run.
+static thread_local GameStateRequestLanes* ListenerLanes = nullptr;
+
+// Parses an unsigned number sent by clients (?since=, Last-Event-ID, filters)
+template<typename T>
+static bool ParseNumber(std::string_view text, T& value)
+{
+    std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// CPUs listener index of count runs on: the configured CPUs split into count
+// contiguous shards, or one CPU each, round robin, when there are fewer CPUs
+static std::vector<uint32> GetListenerCpus(std::vector<uint32> const& cpus, uint32 index, uint32 count)
+{
+    if (cpus.empty())
+        return {};
+
+    if (cpus.size() < count)
+        return { cpus[index % cpus.size()] };
+
+    return std::vector<uint32>(cpus.begin() + cpus.size() * index / count, cpus.begin() + cpus.size() * (index + 1) / count);
+}
+
+// Query parameters that turn /api/players into a filtered, sorted or paged listing
+static constexpr char const* PLAYER_LIST_PARAMS[] =
+{
+    "map_id", "zone_id", "guild_id", "group_id", "class", "race", "level_min", "level_max", "sort", "limit", "cursor"
+};
+
+// Largest page a listing returns, whatever ?limit= asks for
+static constexpr uint32 PLAYER_LIST_MAX_LIMIT = 1000;
+
+// 64-bit FNV-1a, used as the ETag of responses that have no snapshot version
+static uint64 HashContent(std::string const& content)
+{
+    uint64 hash = 14695981039346656037ULL;
+    for (char c : content)
+    {
+        hash ^= static_cast<uint8>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// How long shed clients are told to wait before retrying
+static constexpr Seconds SHED_RETRY_AFTER(1);
+
+// Most players a names=/guids= lookup or a batch may ask for at once
+static constexpr std::size_t PLAYER_BATCH_MAX_ENTRIES = 100;
+
+// Writes the "data" member of one batch entry once its result is ready and
+// returns the entry's status; nothing is written unless that is 200
+using BatchEntryWriter = std::function<int(GameStateJsonWriter& writer, std::chrono::steady_clock::time_point deadline)>;
+
+// Starts capturing a batch entry on the world thread right away, so all
+// entries of a batch are answered within the same world update
+template<typename Snapshot>
+static BatchEntryWriter QueryBatchEntry(ObjectGuid guid, Snapshot (*capture)(Player*), void (*write)(GameStateJsonWriter&, Snapshot const&))
+{
+    std::shared_ptr<std::future<std::optional<Snapshot>>> query =
+        std::make_shared<std::future<std::optional<Snapshot>>>(sGameStateSnapshotMgr->QueryPlayer<Snapshot>(guid, capture));
+
+    return [query, write](GameStateJsonWriter& writer, std::chrono::steady_clock::time_point deadline)
+    {
+        if (query->wait_until(deadline) != std::future_status::ready)
+            return 503;
+
+        std::optional<Snapshot> result = query->get();
+        if (!result)
+            return 404;
+
+        writer.Key("data");
+        write(writer, *result);
+        return 200;
+    };
+}
+
+HttpGameStateServer::HttpGameStateServer(const std::string& host, uint16 port, const std::string& allowedOrigin, HttpServerLimits const& limits)
     : _host(host), _port(port), _allowedOrigin(allowedOrigin), _running(false)
 {
-    _server = std::make_unique<httplib::Server>();
+    uint32 listeners = std::max<uint32>(limits.Listeners, 1);
+#ifndef __linux__
+    if (listeners > 1)
+    {
+        LOG_WARN("module.gamestate_api", "GameStateAPI.Listeners is only supported on Linux, using 1");
+        listeners = 1;
+    }
+#endif
 
-    // Set up CORS middleware for all requests
-    _server->set_pre_routing_handler([this](const httplib::Request& /*req*/, httplib::Response& res) {
-        SetCorsHeaders(res);
-        return httplib::Server::HandlerResponse::Unhandled;
-    });
+    std::size_t threads = limits.Threads ? limits.Threads : CPPHTTPLIB_THREAD_POOL_COUNT;
 
-    // Handle OPTIONS requests for CORS preflight
-    _server->Options(".*", [this](const httplib::Request& /*req*/, httplib::Response& res) {
-        SetCorsHeaders(res);
-        res.status = 200;
-    });
+    // Whatever the other lanes do, ReservedThreads workers of each listener
+    // stay free for Light requests
+    uint32 busyLimit = static_cast<uint32>(threads) > limits.ReservedThreads ? static_cast<uint32>(threads) - limits.ReservedThreads : 1;
+    std::array<uint32, std::size_t(GameStateCostClass::Max)> laneLimits =
+    {
+        0,
+        limits.PlayerLaneThreads,
+        limits.CollectionLaneThreads,
+        limits.StreamLaneThreads
+    };
+
+    bool threaded = true;
+#ifdef __linux__
+    threaded = !limits.Epoll;
+#else
+    if (limits.Epoll)
+        LOG_WARN("module.gamestate_api", "GameStateAPI.Backend \"epoll\" is only available on Linux, using \"threads\"");
+#endif
+
+    _listeners.resize(listeners);
+    for (uint32 i = 0; i < listeners; ++i)
+    {
+        Listener& listener = _listeners[i];
+        listener.Cpus = GetListenerCpus(limits.Cpus, i, listeners);
+
+        // Connections are spread per connection, not per request, so each
+        // listener keeps its own workers free
+        listener.Lanes = std::make_unique<GameStateRequestLanes>(laneLimits, busyLimit);
+        GameStateRequestLanes* lanes = listener.Lanes.get();
+
+#ifdef __linux__
+        if (!threaded)
+        {
+            listener.Reactor = std::make_unique<GameStateEpollServer>(limits, listener.Cpus,
+                [this, lanes](httplib::Request& req, httplib::Response& res, std::shared_ptr<GameStateStream>& stream)
+            {
+                ListenerLanes = lanes;
+                DispatchRequest(req, res, stream);
+            });
+            continue;
+        }
+#endif
+
+        listener.Server = std::make_unique<httplib::Server>();
+        httplib::Server& server = *listener.Server;
+
+        std::size_t maxQueued = limits.MaxQueuedRequests;
+        server.new_task_queue = [threads, maxQueued, cpus = listener.Cpus]() { return new GameStateTaskQueue(threads, maxQueued, cpus); };
+        server.set_keep_alive_max_count(std::max<uint32>(limits.KeepAliveMaxCount, 1));
+        server.set_keep_alive_timeout(limits.KeepAliveTimeout.count());
+        server.set_read_timeout(limits.ReadTimeout);
+        server.set_write_timeout(limits.WriteTimeout);
+
+        // Every listener binds the same port, the kernel spreads the
+        // connections over them
+        server.set_socket_options([](socket_t sock) {
+            httplib::detail::set_socket_opt(sock, SOL_SOCKET, SO_REUSEADDR, 1);
+#ifdef SO_REUSEPORT
+            httplib::detail::set_socket_opt(sock, SOL_SOCKET, SO_REUSEPORT, 1);
+#endif
+        });
+
+        // Every request gets the CORS headers. GET routes are dispatched from
+        // here through the router, so httplib's regex matching only sees the rest.
+        server.set_pre_routing_handler([this, lanes](const httplib::Request& req, httplib::Response& res) {
+            ListenerLanes = lanes;
+            return HandlePreRouting(req, res);
+        });
+
+        // Compress after the handler ran, right before the response is written
+        server.set_post_routing_handler([](const httplib::Request& req, httplib::Response& res) {
+            CompressResponse(req, res);
+        });
+
+        server.Post("/api/batch", [this](const httplib::Request& req, httplib::Response& res) {
+            HandleBatch(req, res);
+        });
+    }
 
-    // API endpoints
-    _server->Get("/api/health", [this](const httplib::Request& req, httplib::Response& res) {
+    // API endpoints. Streams take their lane slot themselves, it has to
+    // outlive the handler for as long as the stream is open.
+    AddRoute("/api/health", GameStateCostClass::Light, [this](const httplib::Request& req, httplib::Response& res, GameStateRouteParams const& /*params*/) {
         HandleHealthCheck(req, res);
     });
 
-    _server->Get("/api/server", [this](const httplib::Request& req, httplib::Response& res) {
+    AddRoute("/api/server", GameStateCostClass::Light, [this](const httplib::Request& req, httplib::Response& res, GameStateRouteParams const& /*params*/) {
         HandleServerInfo(req, res);
     });
 
-    _server->Get("/api/players", [this](const httplib::Request& req, httplib::Response& res) {
+    AddRoute("/api/players", GameStateCostClass::Collection, [this](const httplib::Request& req, httplib::Response& res, GameStateRouteParams const& /*params*/) {
         HandleOnlinePlayers(req, res);
     });
 
-    _server->Get("/api/player/([^/]+)", [this](const httplib::Request& req, httplib::Response& res) {
-        HandlePlayerInfo(req, res);
+    AddRoute("/api/stream", GameStateCostClass::Light, [this](const httplib::Request& req, httplib::Response& res, GameStateRouteParams const& /*params*/) {
+        HandleStream(req, res);
+    });
+
+    AddRoute("/api/map/{id:uint}/players", GameStateCostClass::Collection, [this](const httplib::Request& req, httplib::Response& res, GameStateRouteParams const& params) {
+        HandleMapPlayers(req, res, params[0]);
     });
 
-    _server->Get("/api/player/([^/]+)/stats", [this](const httplib::Request& req, httplib::Response& res) {
-        HandlePlayerStats(req, res);
+    AddRoute("/api/player/{name}", GameStateCostClass::Player, [this](const httplib::Request& req, httplib::Response& res, GameStateRouteParams const& params) {
+        HandlePlayerInfo(req, res, params[0]);
     });
 
-    _server->Get("/api/player/([^/]+)/equipment", [this](const httplib::Request& req, httplib::Response& res) {
-        HandlePlayerEquipment(req, res);
+    AddRoute("/api/player/{name}/stats", GameStateCostClass::Player, [this](const httplib::Request& req, httplib::Response& res, GameStateRouteParams const& params) {
+        HandlePlayerStats(req, res, params[0]);
     });
 
-    _server->Get("/api/player/([^/]+)/skills", [this](const httplib::Request& req, httplib::Response& res) {
-        HandlePlayerSkills(req, res);
+    AddRoute("/api/player/{name}/equipment", GameStateCostClass::Player, [this](const httplib::Request& req, httplib::Response& res, GameStateRouteParams const& params) {
+        HandlePlayerEquipment(req, res, params[0]);
     });
 
-    _server->Get("/api/player/([^/]+)/skills-full", [this](const httplib::Request& req, httplib::Response& res) {
-        HandlePlayerSkillsFull(req, res);
+    AddRoute("/api/player/{name}/skills", GameStateCostClass::Player, [this](const httplib::Request& req, httplib::Response& res, GameStateRouteParams const& params) {
+        HandlePlayerSkills(req, res, params[0]);
     });
 
-    _server->Get("/api/player/([^/]+)/quests", [this](const httplib::Request& req, httplib::Response& res) {
-        HandlePlayerQuests(req, res);
+    AddRoute("/api/player/{name}/skills-full", GameStateCostClass::Player, [this](const httplib::Request& req, httplib::Response& res, GameStateRouteParams const& params) {
+        HandlePlayerSkillsFull(req, res, params[0]);
     });
 
-    // Set up CORS and error handling
-    _server->set_pre_routing_handler([](const httplib::Request& /*req*/, httplib::Response& res) {
-        res.set_header("Access-Control-Allow-Origin", "*");
-        res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
-        res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
-        return httplib::Server::HandlerResponse::Unhandled;
+    AddRoute("/api/player/{name}/quests", GameStateCostClass::Player, [this](const httplib::Request& req, httplib::Response& res, GameStateRouteParams const& params) {
+        HandlePlayerQuests(req, res, params[0]);
     });
 }
 
-HttpGameStateServer::~HttpGameStateServer()
+httplib::Server::HandlerResponse HttpGameStateServer::HandlePreRouting(const httplib::Request& req, httplib::Response& res)
 {
-    Stop();
+    SetCorsHeaders(res);
+
+    // More connections are waiting than the workers can serve in time. The
+    // shedding thread still answers Light requests, so health probes keep
+    // passing, but closes every connection it touched.
+    bool shedding = GameStateTaskQueue::IsShedding();
+    if (shedding)
+        res.set_header("Connection", "close");
+
+    // CORS preflight, for any path
+    if (req.method == "OPTIONS")
+    {
+        res.status = 200;
+        return httplib::Server::HandlerResponse::Handled;
+    }
+
+    // Routes shed their own requests by cost class
+    if (req.method == "GET" || req.method == "HEAD")
+    {
+        GameStateRouteParams params;
+        if (GameStateRouter::Handler const* handler = _router.Match(req.path, params))
+        {
+            (*handler)(req, res, params);
+            return httplib::Server::HandlerResponse::Handled;
+        }
+    }
+
+    if (shedding)
+    {
+        SendOverloadedResponse(res);
+        return httplib::Server::HandlerResponse::Handled;
+    }
+
+    // Anything with a body has to be routed by httplib, which reads it after this handler
+    return httplib::Server::HandlerResponse::Unhandled;
 }
 
-bool HttpGameStateServer::Start()
+void HttpGameStateServer::DispatchRequest(httplib::Request& req, httplib::Response& res, std::shared_ptr<GameStateStream>& stream)
 {
-    if (_running.load())
+    ReactorStream = &stream;
+    try
     {
-        LOG_WARN("module.gamestate_api", "HTTP server is already running");
-        return false;
+        if (HandlePreRouting(req, res) == httplib::Server::HandlerResponse::Unhandled)
+        {
+            if (req.method == "POST" && req.path == "/api/batch")
+                HandleBatch(req, res);
+            else
+                res.status = 404;
+        }
+    }
+    catch (...)
+    {
+        ReactorStream = nullptr;
+        throw;
     }
 
-    _serverThread = std::make_unique<std::thread>([this]() {
-        LOG_INFO("module.gamestate_api", "Starting HTTP server on {}:{}", _host, _port);
-        _running.store(true);
+    ReactorStream = nullptr;
+    if (res.status == -1)
+        res.status = 200;
+
+    CompressResponse(req, res);
+}
 
-        if (!_server->listen(_host, _port))
+void HttpGameStateServer::AddRoute(std::string_view pattern, GameStateCostClass cost, GameStateRouter::Handler handler)
+{
+    _router.Add(pattern, [this, cost, handler = std::move(handler)](const httplib::Request& req, httplib::Response& res, GameStateRouteParams const& params) {
+        if (cost != GameStateCostClass::Light && GameStateTaskQueue::IsShedding())
         {
-            LOG_ERROR("module.gamestate_api", "Failed to start HTTP server on {}:{}", _host, _port);
-            _running.store(false);
+            SendOverloadedResponse(res);
+            return;
         }
-        else
+
+        GameStateRequestLanes::Slot slot = ListenerLanes->TryAcquire(cost);
+        if (!slot)
         {
-            LOG_INFO("module.gamestate_api", "HTTP server stopped");
-            _running.store(false);
+            SendOverloadedResponse(res);
+            return;
         }
+
+        handler(req, res, params);
     });
+}
 
-    // Give the server a moment to start
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+HttpGameStateServer::~HttpGameStateServer()
+{
+    Stop();
+}
 
+bool HttpGameStateServer::Start()
+{
     if (_running.load())
     {
-        LOG_INFO("module.gamestate_api", "Game State API HTTP server started successfully on {}:{}", _host, _port);
-        return true;
+        LOG_WARN("module.gamestate_api", "HTTP server is already running");
+        return false;
     }
-    else
+
+    LOG_INFO("module.gamestate_api", "Starting HTTP server on {}:{} with {} listener(s)", _host, _port, _listeners.size());
+
+    // Every listener binds before this returns, so a port in use fails here
+    for (Listener& listener : _listeners)
     {
-        LOG_ERROR("module.gamestate_api", "Failed to start Game State API HTTP server");
-        if (_serverThread && _serverThread->joinable())
+        bool started = false;
+#ifdef __linux__
+        if (listener.Reactor)
+            started = listener.Reactor->Start(_host, _port);
+#endif
+
+        if (listener.Server && listener.Server->bind_to_port(_host, _port))
         {
-            _serverThread->join();
+            listener.Thread = std::make_unique<std::thread>([&listener]() {
+                GameStateTaskQueue::PinCurrentThread(listener.Cpus);
+                listener.Server->listen_after_bind();
+            });
+
+            listener.Server->wait_until_ready();
+            started = true;
+        }
+
+        if (!started)
+        {
+            LOG_ERROR("module.gamestate_api", "Failed to start Game State API HTTP server on {}:{}", _host, _port);
+            StopListeners();
+            return false;
         }
-        return false;
     }
+
+    _running.store(true);
+    LOG_INFO("module.gamestate_api", "Game State API HTTP server started successfully on {}:{}", _host, _port);
+    return true;
 }
 
 void HttpGameStateServer::Stop()
@@ -135,44 +388,89 @@ void HttpGameStateServer::Stop()
     }
 
     LOG_INFO("module.gamestate_api", "Stopping HTTP server...");
+    StopListeners();
 
-    if (_server)
-    {
-        _server->stop();
-    }
+    _running.store(false);
+    LOG_INFO("module.gamestate_api", "HTTP server stopped");
+}
 
-    if (_serverThread && _serverThread->joinable())
+void HttpGameStateServer::StopListeners()
+{
+    for (Listener& listener : _listeners)
     {
-        _serverThread->join();
-    }
+#ifdef __linux__
+        if (listener.Reactor)
+        {
+            listener.Reactor->Stop();
+        }
+#endif
 
-    _running.store(false);
-    LOG_INFO("module.gamestate_api", "HTTP server stopped");
+        if (listener.Server)
+        {
+            listener.Server->stop();
+        }
+
+        if (listener.Thread && listener.Thread->joinable())
+        {
+            listener.Thread->join();
+        }
+
+        listener.Thread.reset();
+    }
 }
 
-void HttpGameStateServer::HandleHealthCheck(const httplib::Request& /*req*/, httplib::Response& res)
+void HttpGameStateServer::HandleHealthCheck(const httplib::Request& req, httplib::Response& res)
 {
-    json response = {
-        {"status", "ok"},
-        {"timestamp", std::time(nullptr)},
-        {"uptime_seconds", GameTime::GetUptime().count()}
-    };
+    GameStateSnapshotPtr snapshot = sGameStateSnapshotMgr->GetSnapshot();
+    if (!snapshot)
+    {
+        json response = {
+            {"status", "ok"},
+            {"timestamp", std::time(nullptr)},
+            {"uptime_seconds", 0}
+        };
 
-    SendJsonResponse(res, response.dump(2));
+        SendJsonResponse(res, response.dump(GetJsonIndent(req)));
+        return;
+    }
+
+    if (CheckNotModified(req, res, MakeETag(snapshot->Version)))
+        return;
+
+    SendCachedJsonResponse(req, res, *snapshot, "health", [&](GameStateJsonWriter& writer)
+    {
+        writer.BeginObject();
+        writer.Field("status", "ok");
+        writer.Field("timestamp", std::time(nullptr));
+        writer.Field("uptime_seconds", snapshot->Server.UptimeSeconds);
+        writer.EndObject();
+    });
 }
 
-void HttpGameStateServer::HandleServerInfo(const httplib::Request& /*req*/, httplib::Response& res)
+void HttpGameStateServer::HandleServerInfo(const httplib::Request& req, httplib::Response& res)
 {
     try
     {
-        json serverData = GameStateUtilities::GetServerData();
-        SendJsonResponse(res, serverData.dump(2));
+        GameStateSnapshotPtr snapshot = sGameStateSnapshotMgr->GetSnapshot();
+        if (!snapshot)
+        {
+            SendErrorResponse(res, "Game state is not available yet", 503);
+            return;
+        }
+
+        if (CheckNotModified(req, res, MakeETag(snapshot->Version)))
+            return;
+
+        SendCachedJsonResponse(req, res, *snapshot, "server", [&](GameStateJsonWriter& writer)
+        {
+            GameStateUtilities::WriteServerData(writer, snapshot->Server);
+        });
     }
     catch (const std::exception& e)
     {
         LOG_ERROR("module.gamestate_api", "Error getting server info: {}", e.what());
         json error = {{"error", "Internal server error"}, {"status", 500}};
-        SendJsonResponse(res, error.dump(2), 500);
+        SendJsonResponse(res, error.dump(), 500);
     }
 }
 
@@ -183,176 +481,922 @@ void HttpGameStateServer::HandleOnlinePlayers(const httplib::Request& req, httpl
         // Check for equipment parameter
         bool includeEquipment = req.has_param("equipment") && req.get_param_value("equipment") == "true";
 
-        json playersData = GameStateUtilities::GetAllPlayersData(includeEquipment);
+        uint32 fields = 0;
+        if (!GetPlayerFields(req, includeEquipment, fields))
+        {
+            SendErrorResponse(res, "Unknown field in fields", 400);
+            return;
+        }
 
-        json response = {
-            {"count", playersData.size()},
-            {"players", playersData}
-        };
+        PlayerListQuery query;
+        bool listed = false;
+        std::string error;
+        if (!GetPlayerListQuery(req, query, listed, error))
+        {
+            SendErrorResponse(res, error, 400);
+            return;
+        }
+
+        std::vector<std::string> names;
+        std::vector<uint32> guids;
+        if (!GetPlayerSelection(req, names, guids, error))
+        {
+            SendErrorResponse(res, error, 400);
+            return;
+        }
+
+        bool selected = !names.empty() || !guids.empty();
+        if (selected && (listed || req.has_param("since")))
+        {
+            SendErrorResponse(res, "names and guids cannot be combined with since, filters, sort or paging", 400);
+            return;
+        }
+
+        GameStateSnapshotPtr snapshot = sGameStateSnapshotMgr->GetSnapshot(fields | query.GetRequiredFields(), WORLD_QUERY_TIMEOUT);
+        if (!snapshot)
+        {
+            SendErrorResponse(res, "Game state is not available yet", 503);
+            return;
+        }
+
+        // A roster looked up in one request instead of one request per player
+        if (selected)
+        {
+            if (CheckNotModified(req, res, MakeETag(snapshot->PlayersChangedVersion)))
+                return;
 
-        SendJsonResponse(res, response.dump(2));
+            std::string key = "players?fields=" + std::to_string(fields) + "&names=" + req.get_param_value("names") + "&guids=" + req.get_param_value("guids");
+            SendCachedJsonResponse(req, res, *snapshot, std::move(key), [&](GameStateJsonWriter& writer)
+            {
+                GameStateUtilities::WriteSelectedPlayers(writer, *snapshot, names, guids, fields);
+            });
+            return;
+        }
+
+        // Incremental sync: only what changed after the version the client has
+        if (req.has_param("since"))
+        {
+            if (listed)
+            {
+                SendErrorResponse(res, "since cannot be combined with filters, sort or paging", 400);
+                return;
+            }
+
+            uint64 since = 0;
+            if (!ParseNumber(req.get_param_value("since"), since))
+            {
+                SendErrorResponse(res, "Invalid since version", 400);
+                return;
+            }
+
+            if (CheckNotModified(req, res, MakeETag(snapshot->Version)))
+                return;
+
+            // Too old (or from an earlier server run) to diff, start over. Every
+            // such client gets the same document, so they share a cache entry.
+            bool delta = snapshot->CanDiffFrom(since);
+            std::string key = "players?fields=" + std::to_string(fields);
+            key.append(delta ? "&since=" + std::to_string(since) : "&full");
+
+            SendCachedJsonResponse(req, res, *snapshot, std::move(key), [&](GameStateJsonWriter& writer)
+            {
+                if (delta)
+                    GameStateUtilities::WritePlayersDelta(writer, *snapshot, since, fields);
+                else
+                    GameStateUtilities::WritePlayersFull(writer, *snapshot, fields);
+            });
+            return;
+        }
+
+        // The list only depends on the players, so it stays valid across
+        // snapshots in which nobody was added, changed or removed
+        if (CheckNotModified(req, res, MakeETag(snapshot->PlayersChangedVersion)))
+            return;
+
+        if (listed)
+        {
+            SendCachedJsonResponse(req, res, *snapshot, "players?fields=" + std::to_string(fields) + "&" + query.GetKey(), [&](GameStateJsonWriter& writer)
+            {
+                GameStateUtilities::WritePlayerList(writer, *snapshot, query, fields);
+            });
+            return;
+        }
+
+        SendCachedJsonResponse(req, res, *snapshot, "players?fields=" + std::to_string(fields), [&](GameStateJsonWriter& writer)
+        {
+            writer.BeginObject();
+            writer.Field("count", snapshot->Players.size());
+            writer.Key("players");
+            GameStateUtilities::WriteAllPlayersData(writer, *snapshot, fields);
+            writer.EndObject();
+        });
     }
     catch (const std::exception& e)
     {
         LOG_ERROR("module.gamestate_api", "Error getting players list: {}", e.what());
         json error = {{"error", "Internal server error"}, {"status", 500}};
-        SendJsonResponse(res, error.dump(2), 500);
+        SendJsonResponse(res, error.dump(), 500);
     }
 }
 
-void HttpGameStateServer::HandlePlayerInfo(const httplib::Request& req, httplib::Response& res)
+void HttpGameStateServer::HandleStream(const httplib::Request& req, httplib::Response& res)
 {
-    std::string playerName = req.matches[1];
+    bool includeEquipment = req.has_param("equipment") && req.get_param_value("equipment") == "true";
 
-    if (playerName.empty())
+    uint32 fields = 0;
+    if (!GetPlayerFields(req, includeEquipment, fields))
     {
-        SendErrorResponse(res, "Player name is required", 400);
+        SendErrorResponse(res, "Unknown field in fields", 400);
         return;
     }
 
-    // Find the player using GameStateUtilities
-    Player* player = GameStateUtilities::FindPlayerByName(playerName);
-    if (!player || !player->IsInWorld())
+    GameStateSnapshotPtr snapshot = sGameStateSnapshotMgr->GetSnapshot();
+    if (!snapshot)
     {
-        SendErrorResponse(res, "Player not found or not online", 404);
+        SendErrorResponse(res, "Game state is not available yet", 503);
         return;
     }
 
-    // Check if equipment should be included
-    bool includeEquipment = req.has_param("include") &&
-                           req.get_param_value("include").find("equipment") != std::string::npos;
+    // A reconnecting client resumes after the last event it saw, as long as
+    // that version can still be diffed; otherwise it starts with a full event
+    uint64 lastVersion = 0;
+    uint64 lastEventId = 0;
+    if (ParseNumber(req.get_header_value("Last-Event-ID"), lastEventId) && snapshot->CanDiffFrom(lastEventId))
+        lastVersion = lastEventId;
+
+    // A stream would keep the shedding thread busy for as long as it is open
+    if (GameStateTaskQueue::IsShedding())
+    {
+        SendOverloadedResponse(res);
+        return;
+    }
+
+    // HEAD only gets the headers of a stream, there is nothing to open
+    if (req.method == "HEAD")
+    {
+        res.status = 200;
+        res.set_header("Cache-Control", "no-cache");
+        res.set_header("Content-Type", "text/event-stream");
+        return;
+    }
+
+    // The stream outlives this handler, the slot goes with it and is
+    // released once the stream ends. Streams of the epoll backend hold no
+    // worker while open, so they are not limited by a lane.
+    GameStateRequestLanes::Slot slot = ListenerLanes->TryAcquire(ReactorStream ? GameStateCostClass::Light : GameStateCostClass::Stream);
+    if (!slot)
+    {
+        SendOverloadedResponse(res);
+        return;
+    }
+
+    std::shared_ptr<GameStateStream> stream = std::make_shared<GameStateStream>(fields, lastVersion, std::move(slot));
+    res.set_header("Cache-Control", "no-cache");
+
+    // The epoll backend serves every open stream from its own thread
+    if (ReactorStream)
+    {
+        res.status = 200;
+        res.set_header("Content-Type", "text/event-stream");
+        *ReactorStream = std::move(stream);
+        return;
+    }
+
+    // Waits for the next snapshot before handing control back to httplib,
+    // which is when it notices closed connections and server shutdown
+    res.set_chunked_content_provider("text/event-stream", [stream](std::size_t /*offset*/, httplib::DataSink& sink)
+    {
+        // Keeps the sections this stream sends captured
+        sGameStateSnapshotMgr->RequestPlayerFields(stream->GetFields());
+
+        GameStateSnapshotPtr snapshot = sGameStateSnapshotMgr->WaitForSnapshot(stream->GetSeenVersion(), GAME_STATE_STREAM_WAIT_TIMEOUT);
+        if (!snapshot)
+        {
+            // The world is shutting down
+            sink.done();
+            return true;
+        }
 
-    // Get player data using GameStateUtilities
-    json playerJson = GameStateUtilities::GetPlayerData(player, includeEquipment);
+        std::string event = stream->NextEvent(*snapshot, std::chrono::steady_clock::now());
+        if (event.empty())
+            return true;
 
-    SendJsonResponse(res, playerJson.dump());
+        return sink.write(event.data(), event.size());
+    });
 }
 
-void HttpGameStateServer::HandlePlayerStats(const httplib::Request& req, httplib::Response& res)
+void HttpGameStateServer::HandleMapPlayers(const httplib::Request& req, httplib::Response& res, std::string_view mapIdText)
 {
-    std::string playerName = req.matches[1];
+    uint32 mapId = 0;
+    if (!ParseNumber(mapIdText, mapId))
+    {
+        SendErrorResponse(res, "Invalid map id", 400);
+        return;
+    }
 
-    if (playerName.empty())
+    PlayerMapArea area;
+    std::string error;
+    if (!GetPlayerMapArea(req, area, error))
     {
-        SendErrorResponse(res, "Player name is required", 400);
+        SendErrorResponse(res, error, 400);
         return;
     }
 
-    Player* player = GameStateUtilities::FindPlayerByName(playerName);
-    if (!player || !player->IsInWorld())
+    GameStateSnapshotPtr snapshot = sGameStateSnapshotMgr->GetSnapshot();
+    if (!snapshot)
     {
-        SendErrorResponse(res, "Player not found or not online", 404);
+        SendErrorResponse(res, "Game state is not available yet", 503);
         return;
     }
 
-    json statsJson = GameStateUtilities::GetPlayerStats(player);
-    SendJsonResponse(res, statsJson.dump());
+    if (CheckNotModified(req, res, MakeETag(snapshot->PlayersChangedVersion)))
+        return;
+
+    SendCachedJsonResponse(req, res, *snapshot, "map/" + std::to_string(mapId) + "/players?" + area.GetKey(), [&](GameStateJsonWriter& writer)
+    {
+        GameStateUtilities::WritePlayerPositions(writer, *snapshot, mapId, area);
+    });
 }
 
-void HttpGameStateServer::HandlePlayerEquipment(const httplib::Request& req, httplib::Response& res)
+void HttpGameStateServer::HandleBatch(const httplib::Request& req, httplib::Response& res)
 {
-    std::string playerName = req.matches[1];
+    GameStateRequestLanes::Slot slot = ListenerLanes->TryAcquire(GameStateCostClass::Collection);
+    if (!slot)
+    {
+        SendOverloadedResponse(res);
+        return;
+    }
 
-    if (playerName.empty())
+    json entries = json::parse(req.body, nullptr, false);
+    if (!entries.is_array() || entries.size() > PLAYER_BATCH_MAX_ENTRIES)
     {
-        SendErrorResponse(res, "Player name is required", 400);
+        SendErrorResponse(res, "Expected an array of at most " + std::to_string(PLAYER_BATCH_MAX_ENTRIES) + " entries", 400);
         return;
     }
 
-    Player* player = GameStateUtilities::FindPlayerByName(playerName);
-    if (!player || !player->IsInWorld())
+    static std::string const Resources[] = { "info", "equipment", "stats", "skills", "skills-full", "quests" };
+
+    uint32 fields = 0;
+    if (!GetPlayerFields(req, false, fields))
     {
-        SendErrorResponse(res, "Player not found or not online", 404);
+        SendErrorResponse(res, "Unknown field in fields", 400);
         return;
     }
 
-    json equipmentJson = GameStateUtilities::GetPlayerEquipment(player);
-    SendJsonResponse(res, equipmentJson.dump());
+    uint32 snapshotFields = fields;
+    for (json const& entry : entries)
+    {
+        bool named = entry.is_object() && entry.contains("name");
+        bool byGuid = entry.is_object() && entry.contains("guid");
+        bool valid = named != byGuid && (named ? entry["name"].is_string()
+            : entry["guid"].is_number_unsigned() && entry["guid"].get<uint64>() <= std::numeric_limits<uint32>::max());
+
+        std::string resource;
+        if (valid && entry.contains("resource"))
+        {
+            valid = entry["resource"].is_string();
+            resource = valid ? entry["resource"].get<std::string>() : std::string();
+        }
+        else
+            resource = "info";
+
+        if (!valid || std::find(std::begin(Resources), std::end(Resources), resource) == std::end(Resources))
+        {
+            SendErrorResponse(res, "Each entry needs either name or guid, and resource must be one of info, equipment, stats, skills, skills-full, quests", 400);
+            return;
+        }
+
+        if (resource == "equipment")
+            snapshotFields |= PLAYER_FIELD_EQUIPMENT;
+    }
+
+    GameStateSnapshotPtr snapshot = sGameStateSnapshotMgr->GetSnapshot(snapshotFields, WORLD_QUERY_TIMEOUT);
+    if (!snapshot)
+    {
+        SendErrorResponse(res, "Game state is not available yet", 503);
+        return;
+    }
+
+    ResponseVariant variant;
+    if (!GetResponseVariant(req, variant))
+    {
+        SendErrorResponse(res, "Unsupported format", 400);
+        return;
+    }
+
+    try
+    {
+        // Resolve every entry and queue all live queries before waiting on any
+        std::vector<BatchEntryWriter> writers;
+        writers.reserve(entries.size());
+        for (json const& entry : entries)
+        {
+            std::string resource = entry.value("resource", std::string("info"));
+            PlayerSnapshot const* player = entry.contains("name")
+                ? snapshot->FindPlayer(entry["name"].get<std::string>())
+                : snapshot->FindPlayerByGuid(entry["guid"].get<uint32>());
+
+            if (!player)
+                writers.emplace_back([](GameStateJsonWriter&, std::chrono::steady_clock::time_point) { return 404; });
+            else if (resource == "info")
+                writers.emplace_back([&snapshot, player, fields](GameStateJsonWriter& writer, std::chrono::steady_clock::time_point)
+                {
+                    writer.Key("data");
+                    GameStateUtilities::WritePlayerData(writer, *snapshot, *player, fields);
+                    return 200;
+                });
+            else if (resource == "equipment")
+                writers.emplace_back([player](GameStateJsonWriter& writer, std::chrono::steady_clock::time_point)
+                {
+                    writer.Key("data");
+                    GameStateUtilities::WritePlayerEquipment(writer, player->Equipment);
+                    return 200;
+                });
+            else if (resource == "stats")
+                writers.push_back(QueryBatchEntry(player->Guid, GameStateUtilities::GetPlayerStatsSnapshot, GameStateUtilities::WritePlayerStats));
+            else if (resource == "skills")
+                writers.push_back(QueryBatchEntry(player->Guid, GameStateUtilities::GetPlayerSkillsSnapshot, GameStateUtilities::WritePlayerSkills));
+            else if (resource == "skills-full")
+                writers.push_back(QueryBatchEntry(player->Guid, GameStateUtilities::GetPlayerSkillsSnapshot, GameStateUtilities::WritePlayerSkillsFull));
+            else
+                writers.push_back(QueryBatchEntry(player->Guid, GameStateUtilities::GetPlayerQuestsSnapshot, GameStateUtilities::WritePlayerQuests));
+        }
+
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + WORLD_QUERY_TIMEOUT;
+        GameStateCachedResponsePtr response = RenderResponse([&](GameStateJsonWriter& writer)
+        {
+            writer.BeginArray();
+            for (std::size_t i = 0; i < entries.size(); ++i)
+            {
+                json const& entry = entries[i];
+                writer.BeginObject();
+                int status = writers[i](writer, deadline);
+                if (status == 404)
+                    writer.Field("error", "Player not found or not online");
+                else if (status == 503)
+                    writer.Field("error", "World thread did not answer in time");
+
+                if (entry.contains("guid"))
+                    writer.Field("guid", entry["guid"].get<uint32>());
+                else
+                    writer.Field("name", entry["name"].get<std::string>());
+
+                writer.Field("resource", entry.value("resource", std::string("info")));
+                writer.Field("status", status);
+                writer.EndObject();
+            }
+            writer.EndArray();
+        }, variant);
+
+        SendCachedResponse(res, std::move(response));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error answering batch request: {}", e.what());
+        SendErrorResponse(res, "Internal server error", 500);
+    }
 }
 
-void HttpGameStateServer::HandlePlayerSkills(const httplib::Request& req, httplib::Response& res)
+void HttpGameStateServer::HandlePlayerInfo(const httplib::Request& req, httplib::Response& res, std::string_view playerName)
 {
-    std::string playerName = req.matches[1];
+    // Check if equipment should be included
+    bool includeEquipment = req.has_param("include") &&
+                           req.get_param_value("include").find("equipment") != std::string::npos;
 
-    if (playerName.empty())
+    uint32 fields = 0;
+    if (!GetPlayerFields(req, includeEquipment, fields))
     {
-        SendErrorResponse(res, "Player name is required", 400);
+        SendErrorResponse(res, "Unknown field in fields", 400);
         return;
     }
 
-    Player* player = GameStateUtilities::FindPlayerByName(playerName);
-    if (!player || !player->IsInWorld())
+    GameStateSnapshotPtr snapshot = sGameStateSnapshotMgr->GetSnapshot(fields, WORLD_QUERY_TIMEOUT);
+    if (!snapshot)
+    {
+        SendErrorResponse(res, "Game state is not available yet", 503);
+        return;
+    }
+
+    PlayerSnapshot const* player = snapshot->FindPlayer(playerName);
+    if (!player)
     {
         SendErrorResponse(res, "Player not found or not online", 404);
         return;
     }
 
-    json skillsJson = GameStateUtilities::GetPlayerSkills(player);
-    SendJsonResponse(res, skillsJson.dump());
+    if (CheckNotModified(req, res, MakeETag(*player)))
+        return;
+
+    std::string key = "player/" + std::to_string(player->Guid.GetCounter()) + "?fields=" + std::to_string(fields);
+    SendCachedJsonResponse(req, res, *snapshot, std::move(key), [&](GameStateJsonWriter& writer)
+    {
+        GameStateUtilities::WritePlayerData(writer, *snapshot, *player, fields);
+    });
 }
 
-void HttpGameStateServer::HandlePlayerSkillsFull(const httplib::Request& req, httplib::Response& res)
+void HttpGameStateServer::HandlePlayerStats(const httplib::Request& req, httplib::Response& res, std::string_view playerName)
 {
-    std::string playerName = req.matches[1];
+    SendPlayerQueryResponse(req, res, playerName, GameStateUtilities::GetPlayerStatsSnapshot, GameStateUtilities::WritePlayerStats);
+}
 
-    if (playerName.empty())
+void HttpGameStateServer::HandlePlayerEquipment(const httplib::Request& req, httplib::Response& res, std::string_view playerName)
+{
+    GameStateSnapshotPtr snapshot = sGameStateSnapshotMgr->GetSnapshot(PLAYER_FIELD_EQUIPMENT, WORLD_QUERY_TIMEOUT);
+    if (!snapshot)
     {
-        SendErrorResponse(res, "Player name is required", 400);
+        SendErrorResponse(res, "Game state is not available yet", 503);
         return;
     }
 
-    Player* player = GameStateUtilities::FindPlayerByName(playerName);
-    if (!player || !player->IsInWorld())
+    PlayerSnapshot const* player = snapshot->FindPlayer(playerName);
+    if (!player)
     {
         SendErrorResponse(res, "Player not found or not online", 404);
         return;
     }
 
-    json skillsFullJson = GameStateUtilities::GetPlayerSkillsFull(player);
-    SendJsonResponse(res, skillsFullJson.dump());
+    if (CheckNotModified(req, res, MakeETag(*player)))
+        return;
+
+    SendCachedJsonResponse(req, res, *snapshot, "player/" + std::to_string(player->Guid.GetCounter()) + "/equipment", [&](GameStateJsonWriter& writer)
+    {
+        GameStateUtilities::WritePlayerEquipment(writer, player->Equipment);
+    });
+}
+
+void HttpGameStateServer::HandlePlayerSkills(const httplib::Request& req, httplib::Response& res, std::string_view playerName)
+{
+    SendPlayerQueryResponse(req, res, playerName, GameStateUtilities::GetPlayerSkillsSnapshot, GameStateUtilities::WritePlayerSkills);
 }
 
-void HttpGameStateServer::HandlePlayerQuests(const httplib::Request& req, httplib::Response& res)
+void HttpGameStateServer::HandlePlayerSkillsFull(const httplib::Request& req, httplib::Response& res, std::string_view playerName)
 {
-    std::string playerName = req.matches[1];
+    SendPlayerQueryResponse(req, res, playerName, GameStateUtilities::GetPlayerSkillsSnapshot, GameStateUtilities::WritePlayerSkillsFull);
+}
+
+void HttpGameStateServer::HandlePlayerQuests(const httplib::Request& req, httplib::Response& res, std::string_view playerName)
+{
+    SendPlayerQueryResponse(req, res, playerName, GameStateUtilities::GetPlayerQuestsSnapshot, GameStateUtilities::WritePlayerQuests);
+}
 
-    if (playerName.empty())
+template<typename Snapshot>
+void HttpGameStateServer::SendPlayerQueryResponse(const httplib::Request& req, httplib::Response& res, std::string_view playerName,
+    Snapshot (*capture)(Player*), void (*write)(GameStateJsonWriter&, Snapshot const&))
+{
+    GameStateSnapshotPtr snapshot = sGameStateSnapshotMgr->GetSnapshot();
+    if (!snapshot)
     {
-        SendErrorResponse(res, "Player name is required", 400);
+        SendErrorResponse(res, "Game state is not available yet", 503);
         return;
     }
 
-    Player* player = GameStateUtilities::FindPlayerByName(playerName);
-    if (!player || !player->IsInWorld())
+    // Unknown names are answered from the snapshot without involving the world thread
+    PlayerSnapshot const* player = snapshot->FindPlayer(playerName);
+    if (!player)
     {
         SendErrorResponse(res, "Player not found or not online", 404);
         return;
     }
 
-    json questsJson = GameStateUtilities::GetPlayerQuests(player);
-    SendJsonResponse(res, questsJson.dump());
+    // Identical requests for the same player share one world-thread query
+    // and its rendered result while it is in flight
+    ResponseVariant variant;
+    if (!GetResponseVariant(req, variant))
+    {
+        SendErrorResponse(res, "Unsupported format", 400);
+        return;
+    }
+
+    std::string key = std::to_string(player->Guid.GetCounter()) + req.path.substr(req.path.rfind('/')) + variant.GetKey();
+
+    try
+    {
+        GameStateCachedResponsePtr response = _pendingQueries.GetOrRender(key, [&]()
+        {
+            std::shared_ptr<GameStateCachedResponse> error = std::make_shared<GameStateCachedResponse>();
+
+            // Only the capture runs on the world thread, serialization happens here
+            std::future<std::optional<Snapshot>> query = sGameStateSnapshotMgr->QueryPlayer<Snapshot>(player->Guid, capture);
+            if (query.wait_for(WORLD_QUERY_TIMEOUT) != std::future_status::ready)
+            {
+                error->Status = 503;
+                error->Body = GetErrorJson("World thread did not answer in time");
+                return GameStateCachedResponsePtr(std::move(error));
+            }
+
+            std::optional<Snapshot> result = query.get();
+            if (!result)
+            {
+                error->Status = 404;
+                error->Body = GetErrorJson("Player not found or not online");
+                return GameStateCachedResponsePtr(std::move(error));
+            }
+
+            return RenderResponse([&](GameStateJsonWriter& writer)
+            {
+                write(writer, *result);
+            }, variant);
+        }, false);
+
+        // Live data has no version, the body itself has to be compared
+        if (response->Status == 200 && CheckNotModified(req, res, std::to_string(HashContent(response->Body))))
+            return;
+
+        SendCachedResponse(res, std::move(response));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error querying player {}: {}", playerName, e.what());
+        SendErrorResponse(res, "Internal server error", 500);
+    }
 }
 
 void HttpGameStateServer::SetCorsHeaders(httplib::Response& res)
 {
     res.set_header("Access-Control-Allow-Origin", _allowedOrigin);
     res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
-    res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization, X-Requested-With");
+    res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization, X-Requested-With, If-None-Match");
+    res.set_header("Access-Control-Expose-Headers", "ETag");
     res.set_header("Access-Control-Max-Age", "86400");
 }
 
+std::string HttpGameStateServer::MakeETag(uint64 version)
+{
+    return std::to_string(version);
+}
+
+std::string HttpGameStateServer::MakeETag(PlayerSnapshot const& player)
+{
+    return std::to_string(player.Guid.GetCounter()) + "-" + std::to_string(player.ChangedVersion);
+}
+
+bool HttpGameStateServer::CheckNotModified(const httplib::Request& req, httplib::Response& res, std::string const& tag)
+{
+    // Each format and content coding is a separate representation with its own tag
+    ResponseVariant variant;
+    GetResponseVariant(req, variant);
+
+    std::string etag = "\"" + tag;
+    if (variant.Format != GameStateFormat::Json)
+        etag.append("-").append(GameStateFormats::GetName(variant.Format));
+    if (variant.Encoding != GameStateEncoding::Identity)
+        etag.append("-").append(GameStateCompression::GetName(variant.Encoding));
+    etag.append("\"");
+
+    // Make clients revalidate every time instead of trusting a stale copy
+    res.set_header("ETag", etag);
+    res.set_header("Cache-Control", "no-cache");
+
+    std::string const& ifNoneMatch = req.get_header_value("If-None-Match");
+    if (ifNoneMatch.empty())
+        return false;
+
+    // Comma separated list of (possibly weak) tags, or "*"
+    std::string_view tags(ifNoneMatch);
+    while (!tags.empty())
+    {
+        std::size_t end = tags.find(',');
+        std::string_view tag = tags.substr(0, end);
+        tags = end == std::string_view::npos ? std::string_view() : tags.substr(end + 1);
+
+        while (!tag.empty() && (tag.front() == ' ' || tag.front() == '\t'))
+            tag.remove_prefix(1);
+        while (!tag.empty() && (tag.back() == ' ' || tag.back() == '\t'))
+            tag.remove_suffix(1);
+        if (tag.substr(0, 2) == "W/")
+            tag.remove_prefix(2);
+
+        if (tag == "*" || tag == etag)
+        {
+            res.status = 304;
+            res.body.clear();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void HttpGameStateServer::CompressResponse(const httplib::Request& req, httplib::Response& res)
+{
+    if (res.status != 200 && res.status != 304)
+        return;
+
+    res.set_header("Vary", "Accept, Accept-Encoding");
+
+    // Streams, small bodies, range requests and bodies that are already encoded stay as they are
+    if (res.status != 200 || res.body.size() < GAME_STATE_COMPRESSION_MIN_SIZE || !req.ranges.empty() || res.has_header("Content-Encoding"))
+        return;
+
+    GameStateEncoding encoding = GameStateCompression::Negotiate(req.get_header_value("Accept-Encoding"));
+    if (encoding == GameStateEncoding::Identity)
+        return;
+
+    std::string compressed;
+    if (!GameStateCompression::Compress(res.body, encoding, compressed))
+        return;
+
+    res.body.swap(compressed);
+    res.set_header("Content-Encoding", std::string(GameStateCompression::GetName(encoding)));
+
+    // httplib has already set the length of the uncompressed body
+    res.headers.erase("Content-Length");
+    res.set_header("Content-Length", std::to_string(res.body.size()));
+}
+
+int HttpGameStateServer::GetJsonIndent(const httplib::Request& req)
+{
+    // Compact output unless the client opts in with ?pretty=1
+    if (!req.has_param("pretty"))
+        return -1;
+
+    std::string const& pretty = req.get_param_value("pretty");
+    return (pretty == "1" || pretty == "true") ? 2 : -1;
+}
+
+std::string HttpGameStateServer::ResponseVariant::GetKey() const
+{
+    std::string key = "|";
+    key.append(GameStateFormats::GetName(Format)).append(Indent < 0 ? "|compact|" : "|pretty|").append(GameStateCompression::GetName(Encoding));
+    return key;
+}
+
+bool HttpGameStateServer::GetResponseVariant(const httplib::Request& req, ResponseVariant& variant)
+{
+    variant.Encoding = GameStateCompression::Negotiate(req.get_header_value("Accept-Encoding"));
+
+    // ?format= overrides the Accept header, which is awkward to set from a browser
+    if (req.has_param("format"))
+    {
+        std::optional<GameStateFormat> format = GameStateFormats::FromName(req.get_param_value("format"));
+        if (!format)
+            return false;
+
+        variant.Format = *format;
+    }
+    else
+        variant.Format = GameStateFormats::Negotiate(req.get_header_value("Accept"));
+
+    // Binary formats have no layout to choose
+    variant.Indent = variant.Format == GameStateFormat::Json ? GetJsonIndent(req) : -1;
+    return true;
+}
+
+bool HttpGameStateServer::GetPlayerFields(const httplib::Request& req, bool includeEquipment, uint32& fields)
+{
+    fields = PLAYER_FIELDS_DEFAULT;
+    if (req.has_param("fields") && !GameStateUtilities::ParsePlayerFields(req.get_param_value("fields"), fields))
+        return false;
+
+    if (includeEquipment)
+        fields |= PLAYER_FIELD_EQUIPMENT;
+
+    return true;
+}
+
+bool HttpGameStateServer::GetPlayerListQuery(const httplib::Request& req, PlayerListQuery& query, bool& listed, std::string& error)
+{
+    listed = false;
+    for (char const* param : PLAYER_LIST_PARAMS)
+        listed = listed || req.has_param(param);
+
+    if (!listed)
+        return true;
+
+    std::pair<char const*, std::optional<uint32>*> const filters[] =
+    {
+        { "map_id",   &query.MapId },
+        { "zone_id",  &query.ZoneId },
+        { "guild_id", &query.GuildId },
+        { "group_id", &query.GroupId },
+        { "class",    &query.Class },
+        { "race",     &query.Race }
+    };
+
+    for (auto const& [param, filter] : filters)
+    {
+        if (!req.has_param(param))
+            continue;
+
+        uint32 value = 0;
+        if (!ParseNumber(req.get_param_value(param), value))
+        {
+            error = std::string("Invalid ") + param;
+            return false;
+        }
+
+        *filter = value;
+    }
+
+    if ((req.has_param("level_min") && !ParseNumber(req.get_param_value("level_min"), query.LevelMin)) ||
+        (req.has_param("level_max") && !ParseNumber(req.get_param_value("level_max"), query.LevelMax)))
+    {
+        error = "Invalid level range";
+        return false;
+    }
+
+    if (req.has_param("sort") && !GameStateUtilities::ParsePlayerSort(req.get_param_value("sort"), query))
+    {
+        error = "Unknown sort key";
+        return false;
+    }
+
+    if (req.has_param("limit") && (!ParseNumber(req.get_param_value("limit"), query.Limit) || !query.Limit))
+    {
+        error = "Invalid limit";
+        return false;
+    }
+
+    query.Limit = std::min(query.Limit ? query.Limit : PLAYER_LIST_MAX_LIMIT, PLAYER_LIST_MAX_LIMIT);
+
+    // Decoded last, a cursor is only valid for the order it was issued for
+    if (req.has_param("cursor") && !GameStateUtilities::ParsePlayerCursor(req.get_param_value("cursor"), query))
+    {
+        error = "Invalid cursor";
+        return false;
+    }
+
+    return true;
+}
+
+bool HttpGameStateServer::GetPlayerSelection(const httplib::Request& req, std::vector<std::string>& names, std::vector<uint32>& guids, std::string& error)
+{
+    auto split = [](std::string const& list, auto&& add)
+    {
+        std::size_t start = 0;
+        while (start <= list.size())
+        {
+            std::size_t end = std::min(list.find(',', start), list.size());
+            if (end > start && !add(list.substr(start, end - start)))
+                return false;
+            start = end + 1;
+        }
+        return true;
+    };
+
+    if (req.has_param("names"))
+        split(req.get_param_value("names"), [&names](std::string name) { names.push_back(std::move(name)); return true; });
+
+    if (req.has_param("guids") && !split(req.get_param_value("guids"), [&guids](std::string const& text)
+    {
+        uint32 guid = 0;
+        if (!ParseNumber(text, guid))
+            return false;
+        guids.push_back(guid);
+        return true;
+    }))
+    {
+        error = "Invalid guids";
+        return false;
+    }
+
+    if (names.size() + guids.size() > PLAYER_BATCH_MAX_ENTRIES)
+    {
+        error = "At most " + std::to_string(PLAYER_BATCH_MAX_ENTRIES) + " names and guids can be looked up at once";
+        return false;
+    }
+
+    return true;
+}
+
+bool HttpGameStateServer::GetPlayerMapArea(const httplib::Request& req, PlayerMapArea& area, std::string& error)
+{
+    auto parseCoordinate = [](std::string const& text, float& value)
+    {
+        return ParseNumber(text, value) && std::isfinite(value);
+    };
+
+    if (req.has_param("bbox"))
+    {
+        if (req.has_param("radius"))
+        {
+            error = "bbox cannot be combined with radius";
+            return false;
+        }
+
+        // minX,minY,maxX,maxY
+        std::string bbox = req.get_param_value("bbox");
+        float* bounds[] = { &area.MinX, &area.MinY, &area.MaxX, &area.MaxY };
+        std::size_t start = 0;
+        for (std::size_t i = 0; i < std::size(bounds); ++i)
+        {
+            std::size_t end = i + 1 < std::size(bounds) ? bbox.find(',', start) : bbox.size();
+            if (end == std::string::npos || !parseCoordinate(bbox.substr(start, end - start), *bounds[i]))
+            {
+                error = "Invalid bbox, expected minX,minY,maxX,maxY";
+                return false;
+            }
+            start = end + 1;
+        }
+
+        if (area.MinX > area.MaxX || area.MinY > area.MaxY)
+        {
+            error = "Invalid bbox, expected minX,minY,maxX,maxY";
+            return false;
+        }
+
+        area.Whole = false;
+        return true;
+    }
+
+    if (req.has_param("radius") || req.has_param("x") || req.has_param("y"))
+    {
+        float x = 0.0f;
+        float y = 0.0f;
+        float radius = 0.0f;
+        if (!parseCoordinate(req.get_param_value("x"), x) || !parseCoordinate(req.get_param_value("y"), y) ||
+            !parseCoordinate(req.get_param_value("radius"), radius) || radius < 0.0f)
+        {
+            error = "Invalid circle, expected x, y and radius";
+            return false;
+        }
+
+        area.Whole = false;
+        area.MinX = x - radius;
+        area.MinY = y - radius;
+        area.MaxX = x + radius;
+        area.MaxY = y + radius;
+        area.Radius = radius;
+    }
+
+    return true;
+}
+
 void HttpGameStateServer::SendJsonResponse(httplib::Response& res, const std::string& json, int status)
 {
     res.status = status;
     res.set_content(json, "application/json");
 }
 
-void HttpGameStateServer::SendErrorResponse(httplib::Response& res, const std::string& message, int status)
+void HttpGameStateServer::SendCachedJsonResponse(const httplib::Request& req, httplib::Response& res, GameStateSnapshot const& snapshot,
+    std::string key, std::function<void(GameStateJsonWriter&)> const& write)
+{
+    ResponseVariant variant;
+    if (!GetResponseVariant(req, variant))
+    {
+        SendErrorResponse(res, "Unsupported format", 400);
+        return;
+    }
+
+    SendCachedResponse(res, snapshot.Responses.GetOrRender(key.append(variant.GetKey()), [&]()
+    {
+        return RenderResponse(write, variant);
+    }));
+}
+
+GameStateCachedResponsePtr HttpGameStateServer::RenderResponse(std::function<void(GameStateJsonWriter&)> const& write, ResponseVariant const& variant)
+{
+    std::shared_ptr<GameStateCachedResponse> response = std::make_shared<GameStateCachedResponse>();
+    GameStateJsonWriter writer(response->Body, variant.Indent);
+    write(writer);
+
+    GameStateFormats::Transcode(response->Body, variant.Format);
+    response->Format = variant.Format;
+
+    // Compressed once here rather than by CompressResponse on every request
+    std::string compressed;
+    if (variant.Encoding != GameStateEncoding::Identity && response->Body.size() >= GAME_STATE_COMPRESSION_MIN_SIZE &&
+        GameStateCompression::Compress(response->Body, variant.Encoding, compressed))
+    {
+        response->Body.swap(compressed);
+        response->Encoding = variant.Encoding;
+    }
+
+    return response;
+}
+
+void HttpGameStateServer::SendCachedResponse(httplib::Response& res, GameStateCachedResponsePtr response)
+{
+    res.status = response->Status;
+    if (response->Encoding != GameStateEncoding::Identity)
+        res.set_header("Content-Encoding", std::string(GameStateCompression::GetName(response->Encoding)));
+
+    // The body stays shared with the cache, httplib reads it in place
+    std::size_t size = response->Body.size();
+    res.set_content_provider(size, GameStateFormats::GetContentType(response->Format),
+        [response = std::move(response)](std::size_t offset, std::size_t length, httplib::DataSink& sink)
+    {
+        return sink.write(response->Body.data() + offset, length);
+    });
+}
+
+std::string HttpGameStateServer::GetErrorJson(const std::string& message)
 {
     json error = {
         {"error", message},
         {"timestamp", std::time(nullptr)}
     };
-    SendJsonResponse(res, error.dump(), status);
+    return error.dump();
+}
+
+void HttpGameStateServer::SendErrorResponse(httplib::Response& res, const std::string& message, int status)
+{
+    SendJsonResponse(res, GetErrorJson(message), status);
+}
+
+void HttpGameStateServer::SendOverloadedResponse(httplib::Response& res)
+{
+    res.set_header("Retry-After", std::to_string(SHED_RETRY_AFTER.count()));
+    SendErrorResponse(res, "Server is overloaded", 503);
 }
 
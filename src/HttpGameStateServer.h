@@ -6,17 +6,56 @@
 #define HTTP_GAME_STATE_SERVER_H
 
 #include "Define.h"
+#include "Duration.h"
+#include "GameStateJsonWriter.h"
+#include "GameStateRequestLanes.h"
+#include "GameStateRouter.h"
+#include "GameStateSnapshot.h"
 #include <yhirose/httplib.h>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <vector>
+
+class GameStateEpollServer;
+class GameStateStream;
+struct PlayerListQuery;
+struct PlayerMapArea;
+
+// Worker pool and connection limits, from the GameStateAPI.* config
+struct HttpServerLimits
+{
+    uint32 Threads = 0;             // 0 uses httplib's default pool size
+    uint32 MaxQueuedRequests = 0;   // connections waiting for a worker before new ones get 503, 0 for no limit
+    uint32 KeepAliveMaxCount = 100; // requests served per connection
+    Seconds KeepAliveTimeout = Seconds(5);
+    Seconds ReadTimeout = Seconds(5);
+    Seconds WriteTimeout = Seconds(5);
+
+    // Workers only health and server info requests may use, and the most
+    // workers each heavier class may use (0 for no limit of its own)
+    uint32 ReservedThreads = 1;
+    uint32 PlayerLaneThreads = 0;
+    uint32 CollectionLaneThreads = 0;
+    uint32 StreamLaneThreads = 0;
+
+    // Serve connections from an epoll reactor instead of a thread each
+    bool Epoll = false;
+
+    // Accept loops sharing the port, each with Threads workers of its own,
+    // and the CPUs they are spread over (empty to leave them unpinned)
+    uint32 Listeners = 1;
+    std::vector<uint32> Cpus;
+};
 
 // Modern HTTP server using httplib.h
 class HttpGameStateServer
 {
 public:
-    HttpGameStateServer(const std::string& host, uint16 port, const std::string& allowedOrigin);
+    HttpGameStateServer(const std::string& host, uint16 port, const std::string& allowedOrigin, HttpServerLimits const& limits);
     ~HttpGameStateServer();
 
     bool Start();
@@ -25,27 +64,124 @@ public:
 
 private:
     // REST API endpoint handlers
-    void HandlePlayerInfo(const httplib::Request& req, httplib::Response& res);
-    void HandlePlayerStats(const httplib::Request& req, httplib::Response& res);
-    void HandlePlayerEquipment(const httplib::Request& req, httplib::Response& res);
-    void HandlePlayerSkills(const httplib::Request& req, httplib::Response& res);
-    void HandlePlayerSkillsFull(const httplib::Request& req, httplib::Response& res);
-    void HandlePlayerQuests(const httplib::Request& req, httplib::Response& res);
+    void HandlePlayerInfo(const httplib::Request& req, httplib::Response& res, std::string_view playerName);
+    void HandlePlayerStats(const httplib::Request& req, httplib::Response& res, std::string_view playerName);
+    void HandlePlayerEquipment(const httplib::Request& req, httplib::Response& res, std::string_view playerName);
+    void HandlePlayerSkills(const httplib::Request& req, httplib::Response& res, std::string_view playerName);
+    void HandlePlayerSkillsFull(const httplib::Request& req, httplib::Response& res, std::string_view playerName);
+    void HandlePlayerQuests(const httplib::Request& req, httplib::Response& res, std::string_view playerName);
     void HandleServerInfo(const httplib::Request& req, httplib::Response& res);
     void HandleOnlinePlayers(const httplib::Request& req, httplib::Response& res);
     void HandleHealthCheck(const httplib::Request& req, httplib::Response& res);
+    void HandleStream(const httplib::Request& req, httplib::Response& res);
+    void HandleMapPlayers(const httplib::Request& req, httplib::Response& res, std::string_view mapIdText);
+    void HandleBatch(const httplib::Request& req, httplib::Response& res);
+
+    // CORS, load shedding and GET routing, ahead of httplib's own routing
+    httplib::Server::HandlerResponse HandlePreRouting(const httplib::Request& req, httplib::Response& res);
+
+    // Entry point of the epoll backend: routes and compresses a request the
+    // way httplib's handlers would. An opened event stream is stored in stream.
+    void DispatchRequest(httplib::Request& req, httplib::Response& res, std::shared_ptr<GameStateStream>& stream);
+
+    // Adds a GET route whose handler only runs with a slot in cost's lane
+    void AddRoute(std::string_view pattern, GameStateCostClass cost, GameStateRouter::Handler handler);
 
     // Utility methods
     void SetCorsHeaders(httplib::Response& res);
+    static int GetJsonIndent(const httplib::Request& req);
+
+    // PlayerFieldFlags selected by ?fields= (all but equipment by default),
+    // plus equipment when the endpoint's own switch asks for it. False when
+    // the list names an unknown field.
+    static bool GetPlayerFields(const httplib::Request& req, bool includeEquipment, uint32& fields);
+
+    // Filters, sort and page of a /api/players listing. listed is false when
+    // no such parameter was given; returns false with error for invalid ones.
+    static bool GetPlayerListQuery(const httplib::Request& req, PlayerListQuery& query, bool& listed, std::string& error);
+
+    // Players picked by ?names= and ?guids= (comma separated); false with
+    // error for an invalid guid or too many entries
+    static bool GetPlayerSelection(const httplib::Request& req, std::vector<std::string>& names, std::vector<uint32>& guids, std::string& error);
+
+    // Circle (x, y, radius) or box (bbox) of /api/map/{id}/players, the whole
+    // map when neither is given; returns false with error for invalid ones
+    static bool GetPlayerMapArea(const httplib::Request& req, PlayerMapArea& area, std::string& error);
     void SendJsonResponse(httplib::Response& res, const std::string& json, int status = 200);
     void SendErrorResponse(httplib::Response& res, const std::string& message, int status = 400);
 
+    // 503 with Retry-After for requests turned away by load shedding
+    void SendOverloadedResponse(httplib::Response& res);
+
+    // Representation a request asks for, part of every cache key and ETag
+    struct ResponseVariant
+    {
+        GameStateFormat Format = GameStateFormat::Json;
+        int Indent = -1;
+        GameStateEncoding Encoding = GameStateEncoding::Identity;
+
+        std::string GetKey() const;
+    };
+
+    // False when ?format= names an unsupported format
+    static bool GetResponseVariant(const httplib::Request& req, ResponseVariant& variant);
+
+    // Conditional GET: tags the response and, when the client's If-None-Match
+    // already has that tag, turns it into a bodyless 304 and returns true.
+    // Versioned tags are checked before serializing, so a match costs nothing.
+    static std::string MakeETag(uint64 version);
+    static std::string MakeETag(PlayerSnapshot const& player);
+    static bool CheckNotModified(const httplib::Request& req, httplib::Response& res, std::string const& tag);
+
+    // Post-routing: compresses the body with the encoding the client prefers
+    static void CompressResponse(const httplib::Request& req, httplib::Response& res);
+
+    // Serve a document that only depends on the snapshot (and the query) from
+    // the snapshot's response cache. The first request for each key renders
+    // and compresses it, concurrent ones wait for it, and all share the buffer.
+    void SendCachedJsonResponse(const httplib::Request& req, httplib::Response& res, GameStateSnapshot const& snapshot,
+        std::string key, std::function<void(GameStateJsonWriter&)> const& write);
+
+    // Render a 200 response in the requested format, compressed if it is large enough
+    static GameStateCachedResponsePtr RenderResponse(std::function<void(GameStateJsonWriter&)> const& write, ResponseVariant const& variant);
+    static void SendCachedResponse(httplib::Response& res, GameStateCachedResponsePtr response);
+    static std::string GetErrorJson(const std::string& message);
+
+    // Resolve the player named in the route, capture its data with a world-thread
+    // query and serialize the result on the calling HTTP thread. Identical
+    // requests arriving meanwhile wait for that result instead of queueing
+    // another query.
+    template<typename Snapshot>
+    void SendPlayerQueryResponse(const httplib::Request& req, httplib::Response& res, std::string_view playerName,
+        Snapshot (*capture)(Player*), void (*write)(GameStateJsonWriter&, Snapshot const&));
+
     std::string _host;
     uint16 _port;
     std::string _allowedOrigin;
 
-    std::unique_ptr<httplib::Server> _server;
-    std::unique_ptr<std::thread> _serverThread;
+    // Player queries currently waiting on the world thread
+    GameStateResponseCache _pendingQueries;
+
+    // GET routes, dispatched from the pre-routing handler
+    GameStateRouter _router;
+
+    // One accept loop with its own workers and lanes, on its share of the
+    // CPUs. Each has exactly one of the two backends.
+    struct Listener
+    {
+        std::vector<uint32> Cpus;
+        std::unique_ptr<GameStateRequestLanes> Lanes;
+        std::unique_ptr<httplib::Server> Server;
+        std::unique_ptr<std::thread> Thread;
+#ifdef __linux__
+        std::unique_ptr<GameStateEpollServer> Reactor;
+#endif
+    };
+
+    // Stops and joins whichever listeners are running
+    void StopListeners();
+
+    std::vector<Listener> _listeners;
     std::atomic<bool> _running;
 };
 